@@ -30,7 +30,7 @@
    ------------------------------------------------------------ */
 
 /* Maximum number of bands... */
-#define NB 100
+#define NB 1000
 
 /* ------------------------------------------------------------
    Main...
@@ -44,9 +44,16 @@ int main(
 
   static FILE *out;
 
-  static double numin[NB], numax[NB], rad[NB];
+  static double numin[NB], numax[NB];
 
-  static int iarg, ib, ichan, n, nb, track, xtrack, format;
+  static float *bt;
+
+  static int iarg, ib, ichan, ich0[NB], ich1[NB], nb, track, track0, xtrack,
+    format, outfmt, ncid, dimid[3], time_varid, lon_varid, lat_varid,
+    sat_z_varid, sat_lon_varid, sat_lat_varid, numin_varid, numax_varid,
+    bt_varid;
+
+  static size_t start[3], count[3];
 
   /* Check arguments... */
   if (argc < 4)
@@ -57,18 +64,62 @@ int main(
 
   /* Get control parameters... */
   nb = (int) scan_ctl(argc, argv, "NB", -1, "1", NULL);
-  if (nb > NB)
-    ERRMSG("Too many bands!");
+  if (nb < 1 || nb > NB)
+    ERRMSG("Set 1 <= NB <= %d!", NB);
   for (ib = 0; ib < nb; ib++) {
     numin[ib] = scan_ctl(argc, argv, "NUMIN", ib, "", NULL);
     numax[ib] = scan_ctl(argc, argv, "NUMAX", ib, "", NULL);
   }
   format = (int) scan_ctl(argc, argv, "FORMAT", -1, "1", NULL);
+  outfmt = (int) scan_ctl(argc, argv, "OUTFMT", -1, "1", NULL);
 
-  /* Create file... */
+  /* Create ASCII file... */
   printf("Write band data: %s\n", argv[2]);
-  if (!(out = fopen(argv[2], "w")))
-    ERRMSG("Cannot create file!");
+  if (outfmt == 1) {
+    if (!(out = fopen(argv[2], "w")))
+      ERRMSG("Cannot create file!");
+  }
+
+  /* Create netCDF file... */
+  else if (outfmt == 2) {
+    NC(nc_create(argv[2], NC_CLOBBER, &ncid));
+
+    /* Set dimensions... */
+    NC(nc_def_dim(ncid, "NTRACK", NC_UNLIMITED, &dimid[0]));
+    NC(nc_def_dim(ncid, "NXTRACK", L1_NXTRACK, &dimid[1]));
+    NC(nc_def_dim(ncid, "NB", (size_t) nb, &dimid[2]));
+
+    /* Add variables... */
+    add_var(ncid, "time", "s", "time (seconds since 2000-01-01T00:00Z)",
+	    NC_DOUBLE, dimid, &time_varid, 2);
+    add_var(ncid, "lon", "deg", "footprint longitude", NC_DOUBLE, dimid,
+	    &lon_varid, 2);
+    add_var(ncid, "lat", "deg", "footprint latitude", NC_DOUBLE, dimid,
+	    &lat_varid, 2);
+    add_var(ncid, "sat_z", "km", "satellite altitude", NC_DOUBLE, dimid,
+	    &sat_z_varid, 1);
+    add_var(ncid, "sat_lon", "deg", "satellite longitude", NC_DOUBLE, dimid,
+	    &sat_lon_varid, 1);
+    add_var(ncid, "sat_lat", "deg", "satellite latitude", NC_DOUBLE, dimid,
+	    &sat_lat_varid, 1);
+    add_var(ncid, "numin", "cm^-1", "lower band limit", NC_DOUBLE,
+	    &dimid[2], &numin_varid, 1);
+    add_var(ncid, "numax", "cm^-1", "upper band limit", NC_DOUBLE,
+	    &dimid[2], &numax_varid, 1);
+    add_var(ncid, "bt", "K", "band brightness temperature", NC_FLOAT, dimid,
+	    &bt_varid, 3);
+
+    /* Leave define mode... */
+    NC(nc_enddef(ncid));
+
+    /* Write band limits... */
+    NC(nc_put_var_double(ncid, numin_varid, numin));
+    NC(nc_put_var_double(ncid, numax_varid, numax));
+  }
+
+  /* Error... */
+  else
+    ERRMSG("Unknown output format, check OUTFMT!");
 
   /* Loop over IASI files... */
   for (iarg = 3; iarg < argc; iarg++) {
@@ -77,71 +128,139 @@ int main(
     printf("Read IASI Level-1C data file: %s\n", argv[iarg]);
     iasi_read(format, argv[iarg], iasi_rad);
 
-    /* Write header... */
-    if (iarg == 3) {
-      fprintf(out,
-	      "# $1 = time [s]\n"
-	      "# $2 = footprint longitude [deg]\n"
-	      "# $3 = footprint latitude [deg]\n"
-	      "# $4 = satellite altitude [km]\n"
-	      "# $5 = satellite longitude [deg]\n"
-	      "# $6 = satellite latitude [deg]\n");
-      for (ib = 0; ib < nb; ib++)
-	fprintf(out,
-		"# $%d = BT(%.2f/cm...%.2f/cm) [K]\n",
-		7 + ib, numin[ib], numax[ib]);
+    /* Get channel index ranges of the bands [ich0, ich1)
+       (channel frequencies are increasing)... */
+    for (ib = 0; ib < nb; ib++) {
+      ich0[ib] = ich1[ib] = 0;
+      for (ichan = IASI_L1_NCHAN - 1; ichan >= 0; ichan--)
+	if (iasi_rad->freq[ichan] >= numin[ib]
+	    && iasi_rad->freq[ichan] <= numax[ib]) {
+	  ich0[ib] = ichan;
+	  if (ich1[ib] == 0)
+	    ich1[ib] = ichan + 1;
+	}
+      LOG(2, "band %d: %.2f ... %.2f cm^-1 | channels= %d ... %d", ib,
+	  numin[ib], numax[ib], ich0[ib], ich1[ib] - 1);
     }
 
+    /* Allocate... */
+    ALLOC(bt, float,
+	  (size_t) iasi_rad->ntrack * L1_NXTRACK * (size_t) nb);
+
     /* Loop over scans... */
-    for (track = 0; track < iasi_rad->ntrack; track++) {
+#pragma omp parallel for default(none) shared(iasi_rad,nb,numin,numax,ich0,ich1,bt)
+    for (int itrack = 0; itrack < iasi_rad->ntrack; itrack++) {
 
-      /* Write output... */
-      fprintf(out, "\n");
+      /* Prefix sums of finite radiances and their counts... */
+      double csum[IASI_L1_NCHAN + 1];
+      int ccnt[IASI_L1_NCHAN + 1];
 
       /* Loop over footprints... */
-      for (xtrack = 0; xtrack < L1_NXTRACK; xtrack++) {
+      for (int ix = 0; ix < L1_NXTRACK; ix++) {
 
-	/* Write output... */
-	fprintf(out, "%.2f %.4f %.4f %.3f %.4f %.4f",
-		iasi_rad->Time[track][xtrack],
-		iasi_rad->Longitude[track][xtrack],
-		iasi_rad->Latitude[track][xtrack],
-		iasi_rad->Sat_z[track],
-		iasi_rad->Sat_lon[track], iasi_rad->Sat_lat[track]);
-
-	/* Loop over bands... */
-	for (ib = 0; ib < nb; ib++) {
-
-	  /* Get mean radiance... */
-	  n = 0;
-	  rad[ib] = 0;
-	  for (ichan = 0; ichan <= IASI_L1_NCHAN; ichan++)
-	    if (iasi_rad->freq[ichan] >= numin[ib]
-		&& iasi_rad->freq[ichan] <= numax[ib]
-		&& gsl_finite(iasi_rad->Rad[track][xtrack][ichan])) {
-	      rad[ib] += iasi_rad->Rad[track][xtrack][ichan];
-	      n++;
-	    }
-	  if (n > 0)
-	    rad[ib] /= n;
-	  else
-	    rad[ib] = GSL_NAN;
-
-	  /* Convert to brightness temperature... */
-	  rad[ib] = BRIGHT(rad[ib], 0.5 * (numin[ib] + numax[ib]));
+	/* Compute prefix sums... */
+	csum[0] = 0;
+	ccnt[0] = 0;
+	for (int ic = 0; ic < IASI_L1_NCHAN; ic++) {
+	  const float r = iasi_rad->Rad[itrack][ix][ic];
+	  const int ok = gsl_finite(r);
+	  csum[ic + 1] = csum[ic] + (ok ? r : 0.0);
+	  ccnt[ic + 1] = ccnt[ic] + ok;
+	}
 
-	  /* Write output... */
-	  fprintf(out, " %.3f", rad[ib]);
+	/* Get band means and convert to brightness temperature... */
+	float *btp = bt + ((size_t) itrack * L1_NXTRACK + (size_t) ix)
+	  * (size_t) nb;
+	for (int jb = 0; jb < nb; jb++) {
+	  const int n = ccnt[ich1[jb]] - ccnt[ich0[jb]];
+	  const double rad =
+	    (n > 0 ? (csum[ich1[jb]] - csum[ich0[jb]]) / n : GSL_NAN);
+	  btp[jb] = (float) BRIGHT(rad, 0.5 * (numin[jb] + numax[jb]));
 	}
+      }
+    }
+
+    /* Write ASCII file... */
+    if (outfmt == 1) {
+
+      /* Write header... */
+      if (iarg == 3) {
+	fprintf(out,
+		"# $1 = time [s]\n"
+		"# $2 = footprint longitude [deg]\n"
+		"# $3 = footprint latitude [deg]\n"
+		"# $4 = satellite altitude [km]\n"
+		"# $5 = satellite longitude [deg]\n"
+		"# $6 = satellite latitude [deg]\n");
+	for (ib = 0; ib < nb; ib++)
+	  fprintf(out,
+		  "# $%d = BT(%.2f/cm...%.2f/cm) [K]\n",
+		  7 + ib, numin[ib], numax[ib]);
+      }
+
+      /* Loop over scans... */
+      for (track = 0; track < iasi_rad->ntrack; track++) {
 
 	/* Write output... */
 	fprintf(out, "\n");
+
+	/* Loop over footprints... */
+	for (xtrack = 0; xtrack < L1_NXTRACK; xtrack++) {
+
+	  /* Write output... */
+	  fprintf(out, "%.2f %.4f %.4f %.3f %.4f %.4f",
+		  iasi_rad->Time[track][xtrack],
+		  iasi_rad->Longitude[track][xtrack],
+		  iasi_rad->Latitude[track][xtrack],
+		  iasi_rad->Sat_z[track],
+		  iasi_rad->Sat_lon[track], iasi_rad->Sat_lat[track]);
+	  for (ib = 0; ib < nb; ib++)
+	    fprintf(out, " %.3f",
+		    bt[((size_t) track * L1_NXTRACK + (size_t) xtrack)
+		       * (size_t) nb + (size_t) ib]);
+	  fprintf(out, "\n");
+	}
       }
     }
+
+    /* Write netCDF file... */
+    else {
+
+      /* Set array sizes... */
+      start[0] = (size_t) track0;
+      start[1] = start[2] = 0;
+      count[0] = (size_t) iasi_rad->ntrack;
+      count[1] = L1_NXTRACK;
+      count[2] = (size_t) nb;
+
+      /* Write data... */
+      NC(nc_put_vara_double(ncid, time_varid, start, count,
+			    iasi_rad->Time[0]));
+      NC(nc_put_vara_double(ncid, lon_varid, start, count,
+			    iasi_rad->Longitude[0]));
+      NC(nc_put_vara_double(ncid, lat_varid, start, count,
+			    iasi_rad->Latitude[0]));
+      NC(nc_put_vara_double(ncid, sat_z_varid, start, count,
+			    iasi_rad->Sat_z));
+      NC(nc_put_vara_double(ncid, sat_lon_varid, start, count,
+			    iasi_rad->Sat_lon));
+      NC(nc_put_vara_double(ncid, sat_lat_varid, start, count,
+			    iasi_rad->Sat_lat));
+      NC(nc_put_vara_float(ncid, bt_varid, start, count, bt));
+    }
+
+    /* Increment track counter... */
+    track0 += iasi_rad->ntrack;
+
+    /* Free... */
+    free(bt);
   }
 
   /* Close file... */
-  fclose(out);
+  if (outfmt == 1)
+    fclose(out);
+  else
+    NC(nc_close(ncid));
 
   /* Free... */
   free(iasi_rad);
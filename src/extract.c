@@ -38,6 +38,46 @@
 /*! Maximum number of latitudes for meteorological data. */
 #define EY 182
 
+/*! Number of meteorological data snapshots in the ring buffer. */
+#define NMET 3
+
+/*! Maximum number of granules in batch mode. */
+#define NGRAN 10000
+
+/*! Maximum length of granule file names in batch mode. */
+#define LENGRAN 512
+
+/*! Number of pressure levels read per hyperslab of meteorological data. */
+#define NLEVBLK 8
+
+/*! Number of latitudes per tile when transposing meteorological data. */
+#define NLATBLK 16
+
+/* ------------------------------------------------------------
+   Meteorological variables (bit mask)...
+   ------------------------------------------------------------ */
+
+/*! Geopotential height (requires temperature). */
+#define MET_Z 0x01
+
+/*! Temperature. */
+#define MET_T 0x02
+
+/*! Zonal wind. */
+#define MET_U 0x04
+
+/*! Meridional wind. */
+#define MET_V 0x08
+
+/*! Vertical wind. */
+#define MET_W 0x10
+
+/*! Water vapor. */
+#define MET_H2O 0x20
+
+/*! Ozone. */
+#define MET_O3 0x40
+
 /* ------------------------------------------------------------
    Global variables...
    ------------------------------------------------------------ */
@@ -80,6 +120,15 @@ typedef struct {
   /*! Smoothing for pressure levels. */
   int met_sp;
 
+  /*! Output format (1=netCDF classic, 2=NetCDF-4). */
+  int outfmt;
+
+  /*! Deflate level for NetCDF-4 output (0=off, 1-9). */
+  int nc_level;
+
+  /*! Shuffle filter for NetCDF-4 output (0=no, 1=yes). */
+  int nc_shuffle;
+
 } ctl2_t;
 
 /*! Meteorological data. */
@@ -97,6 +146,9 @@ typedef struct {
   /*! Number of pressure levels. */
   int np;
 
+  /*! Loaded variables (bit mask). */
+  int vars;
+
   /*! Longitude [deg]. */
   double lon[EX];
 
@@ -141,17 +193,61 @@ typedef struct {
 
 } met_t;
 
+/*! Ring buffer of meteorological data snapshots. */
+typedef struct {
+
+  /*! Variables to be loaded (bit mask). */
+  int vars;
+
+  /*! Snapshots. */
+  met_t *met[NMET];
+
+  /*! Time of snapshots (seconds since 2000-01-01T00:00Z). */
+  double time[NMET];
+
+  /*! Snapshot is used by current interpolation (1=yes, 0=no). */
+  int use[NMET];
+
+  /*! Snapshot is still being loaded (1=yes, 0=no). */
+  int pending[NMET];
+
+} metbuf_t;
+
+/*! Granule file names. */
+typedef struct {
+
+  /*! IASI Level-1 data file. */
+  char l1file[LENGRAN];
+
+  /*! Output file. */
+  char outfile[LENGRAN];
+
+  /*! Sensing start time (seconds since 2000-01-01T00:00Z). */
+  double time;
+
+} gran_t;
+
 /* ------------------------------------------------------------
    Functions...
    ------------------------------------------------------------ */
 
+/*! Compare sensing start times of granules (for qsort). */
+int cmp_gran(
+  const void *a,
+  const void *b);
+
+/*! Get sensing start time from EUMETSAT file name (or NaN). */
+double get_gran_time(
+  const char *filename);
+
 /*! Get meteorological data for given timestep. */
 void get_met(
   ctl2_t * ctl2,
   char *metbase,
   double t,
-  met_t * met0,
-  met_t * met1);
+  metbuf_t * buf,
+  met_t ** met0,
+  met_t ** met1);
 
 /*! Get meteorological data for timestep. */
 void get_met_help(
@@ -161,6 +257,31 @@ void get_met_help(
   double dt_met,
   char *filename);
 
+/*! Initialize ring buffer of meteorological data. */
+void get_met_init(
+  metbuf_t * buf,
+  int vars);
+
+/*! Load meteorological data file into ring buffer (returns slot or -1). */
+int get_met_load(
+  ctl2_t * ctl2,
+  char *metbase,
+  double tf,
+  double tkeep,
+  int prefetch,
+  metbuf_t * buf);
+
+/*! Start asynchronous loading of meteorological data for given timestep. */
+void get_met_prefetch(
+  ctl2_t * ctl2,
+  char *metbase,
+  double t,
+  metbuf_t * buf);
+
+/*! Release snapshots of the ring buffer. */
+void get_met_release(
+  metbuf_t * buf);
+
 /*! Linear interpolation of 2-D meteorological data. */
 void intpol_met_2d(
   double array[EX][EY],
@@ -181,6 +302,30 @@ void intpol_met_3d(
   double wy,
   double *var);
 
+/*! Interpolation of meteorological data to a column of pressure levels. */
+void intpol_met_column(
+  met_t * met0,
+  met_t * met1,
+  double ts,
+  int np,
+  double *p,
+  double lon,
+  double lat,
+  double *z,
+  double *t);
+
+/*! Horizontal and vertical interpolation of a 3-D field to a column. */
+void intpol_met_column_help(
+  float array[EX][EY][EP],
+  int ix,
+  int iy,
+  double wx,
+  double wy,
+  int np,
+  int *ip,
+  double *wp,
+  double *var);
+
 /*! Spatial interpolation of meteorological data. */
 void intpol_met_space(
   met_t * met,
@@ -227,6 +372,7 @@ void read_ctl2(
 void read_met(
   ctl2_t * ctl2,
   char *filename,
+  int vars,
   met_t * met);
 
 /*! Extrapolate meteorological data at lower boundary. */
@@ -238,6 +384,12 @@ void read_met_geopot(
   ctl2_t * ctl2,
   met_t * met);
 
+/*! Apply 5x5 median filter to geopotential heights of one longitude. */
+void read_met_median(
+  met_t * met,
+  int ix,
+  float help[EY][EP]);
+
 /*! Read and convert variable from meteorological data file. */
 void read_met_help(
   int ncid,
@@ -271,116 +423,232 @@ int main(
 
   static ctl2_t ctl2;
 
+  static metbuf_t metbuf;
+
+  static gran_t *gran;
+
+  FILE *in;
+
+  char line[LEN], *metbase;
+
   met_t *met0, *met1;
 
   double ts;
 
-  int ichan, lay, track = 0, xtrack, format;
+  int ichan, igran, lay, ngran = 0, sort = 1, track = 0, xtrack, format;
 
   /* Check arguments... */
-  if (argc < 4)
-    ERRMSG("Give parameters: <ctl> <iasi_l1_file> <metbase> <out.nc>");
+  if (argc < 5)
+    ERRMSG("Give parameters: <ctl> [<iasi_l1_file> <metbase> <out.nc>"
+	   " | list <granules.txt> <metbase>]");
 
   /* Allocate... */
   ALLOC(iasi_rad, iasi_rad_t, 1);
-  ALLOC(met0, met_t, 1);
-  ALLOC(met1, met_t, 1);
+  ALLOC(gran, gran_t, NGRAN);
+  get_met_init(&metbuf, MET_Z | MET_T);
 
   /* Read control parameters... */
   read_ctl2(argc, argv, &ctl2);
   format = (int) scan_ctl(argc, argv, "FORMAT", -1, "1", NULL);
 
-  /* Read IASI data... */
-  iasi_read(format, argv[2], iasi_rad);
-
-  /* Copy data to struct... */
-  l1.ntrack = (size_t) iasi_rad->ntrack;
-  for (track = 0; track < iasi_rad->ntrack; track++)
-    for (xtrack = 0; xtrack < L1_NXTRACK; xtrack++) {
-      l1.time[track][xtrack]
-	= iasi_rad->Time[track][xtrack];
-      l1.lon[track][xtrack]
-	= iasi_rad->Longitude[track][xtrack];
-      l1.lat[track][xtrack]
-	= iasi_rad->Latitude[track][xtrack];
-      l1.sat_z[track]
-	= iasi_rad->Sat_z[track];
-      l1.sat_lon[track]
-	= iasi_rad->Sat_lon[track];
-      l1.sat_lat[track]
-	= iasi_rad->Sat_lat[track];
-      for (ichan = 0; ichan < L1_NCHAN; ichan++) {
-	l1.nu[ichan]
-	  = iasi_rad->freq[iasi_chan[ichan]];
-	l1.rad[track][xtrack][ichan]
-	  = iasi_rad->Rad[track][xtrack][iasi_chan[ichan]];
+  /* Read list of granules and output files... */
+  if (strcasecmp(argv[2], "list") == 0) {
+    metbase = argv[4];
+    printf("Read granule list: %s\n", argv[3]);
+    if (!(in = fopen(argv[3], "r")))
+      ERRMSG("Cannot open file!");
+    while (fgets(line, LEN, in))
+      if (sscanf(line, "%511s %511s", gran[ngran].l1file,
+		 gran[ngran].outfile) == 2) {
+	if (strlen(gran[ngran].l1file) >= LENGRAN - 1
+	    || strlen(gran[ngran].outfile) >= LENGRAN - 1)
+	  ERRMSG("Granule file name too long!");
+	gran[ngran].time = get_gran_time(gran[ngran].l1file);
+	if (!gsl_finite(gran[ngran].time))
+	  sort = 0;
+	if ((++ngran) >= NGRAN)
+	  ERRMSG("Too many granules!");
       }
-    }
+    fclose(in);
 
-  /* Write netCDF file... */
-  write_l1(argv[4], &l1);
-
-  /* Read meteo data... */
-  l2.ntrack = l1.ntrack;
-  ts = l1.time[l2.ntrack / 2][L1_NXTRACK / 2];
-  get_met(&ctl2, argv[3], ts, met0, met1);
-
-  /* Interpolate meteo data... */
-  for (track = 0; track < (int) l2.ntrack; track++)
-    for (xtrack = 0; xtrack < L1_NXTRACK; xtrack++)
-      for (lay = 0; lay < L2_NLAY; lay++) {
-	l2.time[track][xtrack] = l1.time[track][xtrack];
-	l2.lon[track][xtrack] = l1.lon[track][xtrack];
-	l2.lat[track][xtrack] = l1.lat[track][xtrack];
-	l2.p[lay] = 1013.25 * exp(-2.5 * lay / 7.0);
-	intpol_met_time(met0, met1, ts, l2.p[lay],
-			l2.lon[track][xtrack], l2.lat[track][xtrack],
-			NULL, NULL, &l2.z[track][xtrack][lay],
-			&l2.t[track][xtrack][lay],
-			NULL, NULL, NULL, NULL, NULL, NULL);
+    /* Sort granules in time... */
+    if (sort)
+      qsort(gran, (size_t) ngran, sizeof(gran_t), cmp_gran);
+    else
+      WARN("Cannot get sensing time from file names, keep list order!");
+  }
+
+  /* Set single granule... */
+  else {
+    metbase = argv[3];
+    sprintf(gran[0].l1file, "%s", argv[2]);
+    sprintf(gran[0].outfile, "%s", argv[4]);
+    ngran = 1;
+  }
+
+  /* Set pressure levels... */
+  for (lay = 0; lay < L2_NLAY; lay++)
+    l2.p[lay] = 1013.25 * exp(-2.5 * lay / 7.0);
+
+  /* Run tasks on the thread team... */
+#pragma omp parallel
+#pragma omp single
+  {
+    /* Loop over granules... */
+    for (igran = 0; igran < ngran; igran++) {
+
+      /* Read IASI data... */
+#pragma omp critical (netcdf)
+      iasi_read(format, gran[igran].l1file, iasi_rad);
+
+      /* Copy data to struct... */
+      l1.ntrack = (size_t) iasi_rad->ntrack;
+      for (track = 0; track < iasi_rad->ntrack; track++)
+	for (xtrack = 0; xtrack < L1_NXTRACK; xtrack++) {
+	  l1.time[track][xtrack]
+	    = iasi_rad->Time[track][xtrack];
+	  l1.lon[track][xtrack]
+	    = iasi_rad->Longitude[track][xtrack];
+	  l1.lat[track][xtrack]
+	    = iasi_rad->Latitude[track][xtrack];
+	  l1.sat_z[track]
+	    = iasi_rad->Sat_z[track];
+	  l1.sat_lon[track]
+	    = iasi_rad->Sat_lon[track];
+	  l1.sat_lat[track]
+	    = iasi_rad->Sat_lat[track];
+	  for (ichan = 0; ichan < L1_NCHAN; ichan++) {
+	    l1.nu[ichan]
+	      = iasi_rad->freq[iasi_chan[ichan]];
+	    l1.rad[track][xtrack][ichan]
+	      = iasi_rad->Rad[track][xtrack][iasi_chan[ichan]];
+	  }
+	}
+
+      /* Start loading meteo data... */
+      l2.ntrack = l1.ntrack;
+      ts = l1.time[l2.ntrack / 2][L1_NXTRACK / 2];
+      get_met_release(&metbuf);
+      get_met_prefetch(&ctl2, metbase, ts, &metbuf);
+
+      /* Write netCDF file (while meteo data are loaded)... */
+      if (ctl2.outfmt == 1) {
+#pragma omp critical (netcdf)
+	write_l1(gran[igran].outfile, &l1);
+      }
+
+      /* Get meteo data... */
+      get_met(&ctl2, metbase, ts, &metbuf, &met0, &met1);
+
+      /* Start loading meteo data of next time step... */
+      if (igran < ngran - 1)
+	get_met_prefetch(&ctl2, metbase, ts + ctl2.dt_met, &metbuf);
+
+      /* Interpolate meteo data... */
+#pragma omp taskloop default(none) shared(l1,l2,met0,met1,ts)
+      for (int itrack = 0; itrack < (int) l2.ntrack; itrack++)
+	for (int ixtrack = 0; ixtrack < L1_NXTRACK; ixtrack++) {
+	  l2.time[itrack][ixtrack] = l1.time[itrack][ixtrack];
+	  l2.lon[itrack][ixtrack] = l1.lon[itrack][ixtrack];
+	  l2.lat[itrack][ixtrack] = l1.lat[itrack][ixtrack];
+	  intpol_met_column(met0, met1, ts, L2_NLAY, l2.p,
+			    l2.lon[itrack][ixtrack], l2.lat[itrack][ixtrack],
+			    l2.z[itrack][ixtrack], l2.t[itrack][ixtrack]);
+	}
+
+      /* Write netCDF file... */
+#pragma omp critical (netcdf)
+      {
+	if (ctl2.outfmt == 1)
+	  write_l2(gran[igran].outfile, &l2);
+	else
+	  write_l1_l2(gran[igran].outfile, &l1, &l2, ctl2.nc_level,
+		      ctl2.nc_shuffle);
       }
+    }
 
-  /* Write netCDF file... */
-  write_l2(argv[4], &l2);
+    /* Wait for pending loads... */
+#pragma omp taskwait
+  }
 
   /* Free... */
   free(iasi_rad);
-  free(met0);
-  free(met1);
+  free(gran);
+  for (int i = 0; i < NMET; i++)
+    free(metbuf.met[i]);
 
   return EXIT_SUCCESS;
 }
 
 /*****************************************************************************/
 
+int cmp_gran(
+  const void *a,
+  const void *b) {
+
+  const double ta = ((const gran_t *) a)->time;
+  const double tb = ((const gran_t *) b)->time;
+
+  return (ta > tb) - (ta < tb);
+}
+
+/*****************************************************************************/
+
+double get_gran_time(
+  const char *filename) {
+
+  int year, mon, day, hour, min, sec;
+
+  /* Get base name... */
+  const char *s = strrchr(filename, '/');
+  s = (s ? s + 1 : filename);
+
+  /* Find first time stamp (IASI_xxx_1C_M0x_yyyymmddHHMMSSZ_...)... */
+  for (; *s; s++) {
+    int n = 0;
+    while (n < 14 && s[n] >= '0' && s[n] <= '9')
+      n++;
+    if (n == 14 && s[n] == 'Z'
+	&& sscanf(s, "%4d%2d%2d%2d%2d%2d", &year, &mon, &day, &hour, &min,
+		  &sec) == 6) {
+      double t;
+      time2jsec(year, mon, day, hour, min, sec, 0, &t);
+      return t;
+    }
+  }
+
+  return GSL_NAN;
+}
+
+/*****************************************************************************/
+
 void get_met(
   ctl2_t *ctl2,
   char *metbase,
   double t,
-  met_t *met0,
-  met_t *met1) {
+  metbuf_t *buf,
+  met_t **met0,
+  met_t **met1) {
 
-  char filename[LEN];
+  /* Release snapshots... */
+  get_met_release(buf);
 
-  static int init;
+  /* Get file times... */
+  const double t0 = floor(t / ctl2->dt_met) * ctl2->dt_met;
+  const double t1 = t0 + ctl2->dt_met;
 
-  /* Init... */
-  if (!init) {
-    init = 1;
+  /* Load data (if not already in the buffer)... */
+  const int i0 = get_met_load(ctl2, metbase, t0, t1, 0, buf);
+  const int i1 = get_met_load(ctl2, metbase, t1, t0, 0, buf);
 
-    get_met_help(t, -1, metbase, ctl2->dt_met, filename);
-    read_met(ctl2, filename, met0);
+  /* Set pointers... */
+  buf->use[i0] = buf->use[i1] = 1;
+  *met0 = buf->met[i0];
+  *met1 = buf->met[i1];
 
-    get_met_help(t + 1.0, 1, metbase, ctl2->dt_met, filename);
-    read_met(ctl2, filename, met1);
-  }
-
-  /* Read new data for forward trajectories... */
-  if (t > met1->time) {
-    memcpy(met0, met1, sizeof(met_t));
-    get_met_help(t, 1, metbase, ctl2->dt_met, filename);
-    read_met(ctl2, filename, met1);
-  }
+  /* Wait for loads of these snapshots only... */
+  met_t *m0 = *met0, *m1 = *met1;
+#pragma omp taskwait depend(in: *m0, *m1)
 }
 
 /*****************************************************************************/
@@ -411,6 +679,117 @@ void get_met_help(
 
 /*****************************************************************************/
 
+void get_met_init(
+  metbuf_t *buf,
+  int vars) {
+
+  /* Allocate snapshots... */
+  for (int i = 0; i < NMET; i++) {
+    ALLOC(buf->met[i], met_t, 1);
+    buf->time[i] = GSL_NAN;
+    buf->use[i] = 0;
+    buf->pending[i] = 0;
+  }
+
+  /* Set variables (geopotential heights need temperature)... */
+  buf->vars = ((vars & MET_Z) ? (vars | MET_T) : vars);
+}
+
+/*****************************************************************************/
+
+int get_met_load(
+  ctl2_t *ctl2,
+  char *metbase,
+  double tf,
+  double tkeep,
+  int prefetch,
+  metbuf_t *buf) {
+
+  char filename[LEN];
+
+  int i, pending[NMET];
+
+  /* Check if data are already loaded or being loaded... */
+  for (i = 0; i < NMET; i++)
+    if (buf->time[i] == tf)
+      return i;
+
+  /* Get load status (reset by the load tasks)... */
+  for (i = 0; i < NMET; i++) {
+#pragma omp atomic read
+    pending[i] = buf->pending[i];
+  }
+
+  /* Find free slot (empty or not needed anymore, never being loaded)... */
+  for (i = 0; i < NMET; i++)
+    if (!gsl_finite(buf->time[i]) && !pending[i])
+      break;
+  if (i >= NMET)
+    for (i = 0; i < NMET; i++)
+      if (!buf->use[i] && !pending[i] && buf->time[i] != tkeep)
+	break;
+  if (i >= NMET) {
+    if (prefetch)
+      return -1;
+    ERRMSG("No free slot in meteo data buffer, increase NMET!");
+  }
+
+  /* Read data asynchronously... */
+  buf->time[i] = tf;
+  buf->pending[i] = 1;
+  get_met_help(tf, -1, metbase, ctl2->dt_met, filename);
+  met_t *met = buf->met[i];
+  int *done = &buf->pending[i];
+  const int vars = buf->vars;
+#pragma omp task default(none) firstprivate(ctl2,filename,vars,met,done) \
+  depend(out: *met)
+  {
+    read_met(ctl2, filename, vars, met);
+#pragma omp atomic write
+    *done = 0;
+  }
+
+  return i;
+}
+
+/*****************************************************************************/
+
+void get_met_prefetch(
+  ctl2_t *ctl2,
+  char *metbase,
+  double t,
+  metbuf_t *buf) {
+
+  FILE *in;
+
+  char filename[LEN];
+
+  /* Get file times... */
+  const double t0 = floor(t / ctl2->dt_met) * ctl2->dt_met;
+  const double t1 = t0 + ctl2->dt_met;
+
+  /* Start loading data (skip missing files and full buffer)... */
+  for (int i = 0; i < 2; i++) {
+    get_met_help(i == 0 ? t0 : t1, -1, metbase, ctl2->dt_met, filename);
+    if (!(in = fopen(filename, "r")))
+      continue;
+    fclose(in);
+    get_met_load(ctl2, metbase, i == 0 ? t0 : t1, i == 0 ? t1 : t0, 1, buf);
+  }
+}
+
+/*****************************************************************************/
+
+void get_met_release(
+  metbuf_t *buf) {
+
+  /* Release snapshots (pending loads are kept)... */
+  for (int i = 0; i < NMET; i++)
+    buf->use[i] = 0;
+}
+
+/*****************************************************************************/
+
 void intpol_met_2d(
   double array[EX][EY],
   int ix,
@@ -465,6 +844,107 @@ void intpol_met_3d(
 
 /*****************************************************************************/
 
+void intpol_met_column(
+  met_t *met0,
+  met_t *met1,
+  double ts,
+  int np,
+  double *p,
+  double lon,
+  double lat,
+  double *z,
+  double *t) {
+
+  met_t *met[2] = { met0, met1 };
+
+  double wp[EP], wx, wy, wt, zz[2][EP], tt[2][EP];
+
+  int ip[EP], ix, iy;
+
+  /* Check number of levels... */
+  if (np > EP)
+    ERRMSG("Too many pressure levels!");
+
+  /* Loop over time steps... */
+  for (int i = 0; i < 2; i++) {
+
+    /* Check longitude... */
+    double lon2 = lon;
+    if (met[i]->lon[met[i]->nx - 1] > 180 && lon2 < 0)
+      lon2 += 360;
+
+    /* Get horizontal indices and weights (once per column)... */
+    ix = locate_reg(met[i]->lon, met[i]->nx, lon2);
+    iy = locate_reg(met[i]->lat, met[i]->ny, lat);
+    wx = (met[i]->lon[ix + 1] - lon2)
+      / (met[i]->lon[ix + 1] - met[i]->lon[ix]);
+    wy = (met[i]->lat[iy + 1] - lat)
+      / (met[i]->lat[iy + 1] - met[i]->lat[iy]);
+
+    /* Get vertical indices and weights... */
+    for (int lay = 0; lay < np; lay++) {
+      ip[lay] = locate_irr(met[i]->p, met[i]->np, p[lay]);
+      wp[lay] = (met[i]->p[ip[lay] + 1] - p[lay])
+	/ (met[i]->p[ip[lay] + 1] - met[i]->p[ip[lay]]);
+    }
+
+    /* Interpolate... */
+    if (z != NULL)
+      intpol_met_column_help(met[i]->z, ix, iy, wx, wy, np, ip, wp, zz[i]);
+    if (t != NULL)
+      intpol_met_column_help(met[i]->t, ix, iy, wx, wy, np, ip, wp, tt[i]);
+  }
+
+  /* Get weighting factor... */
+  wt = (met1->time - ts) / (met1->time - met0->time);
+
+  /* Interpolate in time... */
+  for (int lay = 0; lay < np; lay++) {
+    if (z != NULL)
+      z[lay] = wt * (zz[0][lay] - zz[1][lay]) + zz[1][lay];
+    if (t != NULL)
+      t[lay] = wt * (tt[0][lay] - tt[1][lay]) + tt[1][lay];
+  }
+}
+
+/*****************************************************************************/
+
+void intpol_met_column_help(
+  float array[EX][EY][EP],
+  int ix,
+  int iy,
+  double wx,
+  double wy,
+  int np,
+  int *ip,
+  double *wp,
+  double *var) {
+
+  /* Get columns at the corners of the grid box... */
+  const float *c00 = array[ix][iy];
+  const float *c01 = array[ix][iy + 1];
+  const float *c10 = array[ix + 1][iy];
+  const float *c11 = array[ix + 1][iy + 1];
+
+  /* Loop over levels... */
+  for (int lay = 0; lay < np; lay++) {
+
+    /* Interpolate vertically... */
+    const int i0 = ip[lay], i1 = ip[lay] + 1;
+    double aux00 = wp[lay] * (c00[i0] - c00[i1]) + c00[i1];
+    double aux01 = wp[lay] * (c01[i0] - c01[i1]) + c01[i1];
+    double aux10 = wp[lay] * (c10[i0] - c10[i1]) + c10[i1];
+    double aux11 = wp[lay] * (c11[i0] - c11[i1]) + c11[i1];
+
+    /* Interpolate horizontally... */
+    aux00 = wy * (aux00 - aux01) + aux01;
+    aux11 = wy * (aux10 - aux11) + aux11;
+    var[lay] = wx * (aux00 - aux11) + aux11;
+  }
+}
+
+/*****************************************************************************/
+
 void intpol_met_space(
   met_t *met,
   double p,
@@ -609,6 +1089,15 @@ void read_ctl2(
   ctl2->met_sx = (int) scan_ctl(argc, argv, "MET_SX", -1, "20", NULL);
   ctl2->met_sy = (int) scan_ctl(argc, argv, "MET_SY", -1, "10", NULL);
   ctl2->met_sp = (int) scan_ctl(argc, argv, "MET_SP", -1, "1", NULL);
+
+  /* Output... */
+  ctl2->outfmt = (int) scan_ctl(argc, argv, "OUTFMT", -1, "1", NULL);
+  if (ctl2->outfmt != 1 && ctl2->outfmt != 2)
+    ERRMSG("Unknown output format, check OUTFMT!");
+  ctl2->nc_level = (int) scan_ctl(argc, argv, "NC_LEVEL", -1, "0", NULL);
+  if (ctl2->nc_level < 0 || ctl2->nc_level > 9)
+    ERRMSG("NC_LEVEL must be between 0 and 9!");
+  ctl2->nc_shuffle = (int) scan_ctl(argc, argv, "NC_SHUFFLE", -1, "1", NULL);
 }
 
 /*****************************************************************************/
@@ -616,11 +1105,12 @@ void read_ctl2(
 void read_met(
   ctl2_t *ctl2,
   char *filename,
+  int vars,
   met_t *met) {
 
   char levname[LEN], tstr[10];
 
-  static float help[EX * EY];
+  float *help;
 
   int ix, iy, ip, dimid, ncid, varid, year, mon, day, hour;
 
@@ -640,55 +1130,113 @@ void read_met(
   hour = atoi(tstr);
   time2jsec(year, mon, day, hour, 0, 0, 0, &met->time);
 
-  /* Open netCDF file... */
-  NC(nc_open(filename, NC_NOWRITE, &ncid));
-
-  /* Get dimensions... */
-  NC(nc_inq_dimid(ncid, "lon", &dimid));
-  NC(nc_inq_dimlen(ncid, dimid, &nx));
-  if (nx < 2 || nx > EX)
-    ERRMSG("Number of longitudes out of range!");
-
-  NC(nc_inq_dimid(ncid, "lat", &dimid));
-  NC(nc_inq_dimlen(ncid, dimid, &ny));
-  if (ny < 2 || ny > EY)
-    ERRMSG("Number of latitudes out of range!");
-
-  sprintf(levname, "lev");
-  NC(nc_inq_dimid(ncid, levname, &dimid));
-  NC(nc_inq_dimlen(ncid, dimid, &np));
-  if (np == 1) {
-    sprintf(levname, "lev_2");
+  /* Set variables (geopotential heights need temperature)... */
+  met->vars = ((vars & MET_Z) ? (vars | MET_T) : vars);
+
+  /* Allocate... */
+  ALLOC(help, float, EX * EY);
+
+  /* Read netCDF file (the netCDF library is not thread-safe)... */
+#pragma omp critical (netcdf)
+  {
+
+    /* Open netCDF file... */
+    NC(nc_open(filename, NC_NOWRITE, &ncid));
+
+    /* Get dimensions... */
+    NC(nc_inq_dimid(ncid, "lon", &dimid));
+    NC(nc_inq_dimlen(ncid, dimid, &nx));
+    if (nx < 2 || nx > EX)
+      ERRMSG("Number of longitudes out of range!");
+
+    NC(nc_inq_dimid(ncid, "lat", &dimid));
+    NC(nc_inq_dimlen(ncid, dimid, &ny));
+    if (ny < 2 || ny > EY)
+      ERRMSG("Number of latitudes out of range!");
+
+    sprintf(levname, "lev");
     NC(nc_inq_dimid(ncid, levname, &dimid));
     NC(nc_inq_dimlen(ncid, dimid, &np));
+    if (np == 1) {
+      sprintf(levname, "lev_2");
+      NC(nc_inq_dimid(ncid, levname, &dimid));
+      NC(nc_inq_dimlen(ncid, dimid, &np));
+    }
+    if (np < 2 || np > EP)
+      ERRMSG("Number of levels out of range!");
+
+    /* Store dimensions... */
+    met->np = (int) np;
+    met->nx = (int) nx;
+    met->ny = (int) ny;
+
+    /* Get horizontal grid... */
+    NC(nc_inq_varid(ncid, "lon", &varid));
+    NC(nc_get_var_double(ncid, varid, met->lon));
+    NC(nc_inq_varid(ncid, "lat", &varid));
+    NC(nc_get_var_double(ncid, varid, met->lat));
+
+    /* Read pressure levels from file... */
+    NC(nc_inq_varid(ncid, levname, &varid));
+    NC(nc_get_var_double(ncid, varid, met->p));
+    for (ip = 0; ip < met->np; ip++)
+      met->p[ip] /= 100.;
+  }
+
+  /* Read meteorological data (one task per variable)... */
+  if (met->vars & MET_T) {
+#pragma omp task default(none) shared(met) firstprivate(ncid)
+    read_met_help(ncid, "t", "T", met, met->t, 1.0);
+  }
+  if (met->vars & MET_U) {
+#pragma omp task default(none) shared(met) firstprivate(ncid)
+    read_met_help(ncid, "u", "U", met, met->u, 1.0);
+  }
+  if (met->vars & MET_V) {
+#pragma omp task default(none) shared(met) firstprivate(ncid)
+    read_met_help(ncid, "v", "V", met, met->v, 1.0);
   }
-  if (np < 2 || np > EP)
-    ERRMSG("Number of levels out of range!");
-
-  /* Store dimensions... */
-  met->np = (int) np;
-  met->nx = (int) nx;
-  met->ny = (int) ny;
-
-  /* Get horizontal grid... */
-  NC(nc_inq_varid(ncid, "lon", &varid));
-  NC(nc_get_var_double(ncid, varid, met->lon));
-  NC(nc_inq_varid(ncid, "lat", &varid));
-  NC(nc_get_var_double(ncid, varid, met->lat));
-
-  /* Read meteorological data... */
-  read_met_help(ncid, "t", "T", met, met->t, 1.0);
-  read_met_help(ncid, "u", "U", met, met->u, 1.0);
-  read_met_help(ncid, "v", "V", met, met->v, 1.0);
-  read_met_help(ncid, "w", "W", met, met->w, 0.01f);
-  read_met_help(ncid, "q", "Q", met, met->h2o, 1.608f);
-  read_met_help(ncid, "o3", "O3", met, met->o3, 0.602f);
-
-  /* Read pressure levels from file... */
-  NC(nc_inq_varid(ncid, levname, &varid));
-  NC(nc_get_var_double(ncid, varid, met->p));
-  for (ip = 0; ip < met->np; ip++)
-    met->p[ip] /= 100.;
+  if (met->vars & MET_W) {
+#pragma omp task default(none) shared(met) firstprivate(ncid)
+    read_met_help(ncid, "w", "W", met, met->w, 0.01f);
+  }
+  if (met->vars & MET_H2O) {
+#pragma omp task default(none) shared(met) firstprivate(ncid)
+    read_met_help(ncid, "q", "Q", met, met->h2o, 1.608f);
+  }
+  if (met->vars & MET_O3) {
+#pragma omp task default(none) shared(met) firstprivate(ncid)
+    read_met_help(ncid, "o3", "O3", met, met->o3, 0.602f);
+  }
+#pragma omp taskwait
+
+#pragma omp critical (netcdf)
+  {
+
+    /* Read surface pressure... */
+    if (nc_inq_varid(ncid, "ps", &varid) == NC_NOERR
+	|| nc_inq_varid(ncid, "PS", &varid) == NC_NOERR) {
+      NC(nc_get_var_float(ncid, varid, help));
+      for (iy = 0; iy < met->ny; iy++)
+	for (ix = 0; ix < met->nx; ix++)
+	  met->ps[ix][iy] = help[iy * met->nx + ix] / 100.;
+    } else if (nc_inq_varid(ncid, "lnsp", &varid) == NC_NOERR
+	       || nc_inq_varid(ncid, "LNSP", &varid) == NC_NOERR) {
+      NC(nc_get_var_float(ncid, varid, help));
+      for (iy = 0; iy < met->ny; iy++)
+	for (ix = 0; ix < met->nx; ix++)
+	  met->ps[ix][iy] = exp(help[iy * met->nx + ix]) / 100.;
+    } else
+      for (ix = 0; ix < met->nx; ix++)
+	for (iy = 0; iy < met->ny; iy++)
+	  met->ps[ix][iy] = met->p[0];
+
+    /* Close file... */
+    NC(nc_close(ncid));
+  }
+
+  /* Free... */
+  free(help);
 
   /* Extrapolate data for lower boundary... */
   read_met_extrapolate(met);
@@ -698,24 +1246,6 @@ void read_met(
     if (met->p[ip - 1] < met->p[ip])
       ERRMSG("Pressure levels must be descending!");
 
-  /* Read surface pressure... */
-  if (nc_inq_varid(ncid, "ps", &varid) == NC_NOERR
-      || nc_inq_varid(ncid, "PS", &varid) == NC_NOERR) {
-    NC(nc_get_var_float(ncid, varid, help));
-    for (iy = 0; iy < met->ny; iy++)
-      for (ix = 0; ix < met->nx; ix++)
-	met->ps[ix][iy] = help[iy * met->nx + ix] / 100.;
-  } else if (nc_inq_varid(ncid, "lnsp", &varid) == NC_NOERR
-	     || nc_inq_varid(ncid, "LNSP", &varid) == NC_NOERR) {
-    NC(nc_get_var_float(ncid, varid, help));
-    for (iy = 0; iy < met->ny; iy++)
-      for (ix = 0; ix < met->nx; ix++)
-	met->ps[ix][iy] = exp(help[iy * met->nx + ix]) / 100.;
-  } else
-    for (ix = 0; ix < met->nx; ix++)
-      for (iy = 0; iy < met->ny; iy++)
-	met->ps[ix][iy] = met->p[0];
-
   /* Create periodic boundary conditions... */
   read_met_periodic(met);
 
@@ -724,9 +1254,6 @@ void read_met(
 
   /* Downsampling... */
   read_met_sample(ctl2, met);
-
-  /* Close file... */
-  NC(nc_close(ncid));
 }
 
 /*****************************************************************************/
@@ -742,20 +1269,26 @@ void read_met_extrapolate(
 
       /* Find lowest valid data point... */
       for (ip0 = met->np - 1; ip0 >= 0; ip0--)
-	if (!gsl_finite(met->t[ix][iy][ip0])
-	    || !gsl_finite(met->u[ix][iy][ip0])
-	    || !gsl_finite(met->v[ix][iy][ip0])
-	    || !gsl_finite(met->w[ix][iy][ip0]))
+	if (((met->vars & MET_T) && !gsl_finite(met->t[ix][iy][ip0]))
+	    || ((met->vars & MET_U) && !gsl_finite(met->u[ix][iy][ip0]))
+	    || ((met->vars & MET_V) && !gsl_finite(met->v[ix][iy][ip0]))
+	    || ((met->vars & MET_W) && !gsl_finite(met->w[ix][iy][ip0])))
 	  break;
 
       /* Extrapolate... */
       for (ip = ip0; ip >= 0; ip--) {
-	met->t[ix][iy][ip] = met->t[ix][iy][ip + 1];
-	met->u[ix][iy][ip] = met->u[ix][iy][ip + 1];
-	met->v[ix][iy][ip] = met->v[ix][iy][ip + 1];
-	met->w[ix][iy][ip] = met->w[ix][iy][ip + 1];
-	met->h2o[ix][iy][ip] = met->h2o[ix][iy][ip + 1];
-	met->o3[ix][iy][ip] = met->o3[ix][iy][ip + 1];
+	if (met->vars & MET_T)
+	  met->t[ix][iy][ip] = met->t[ix][iy][ip + 1];
+	if (met->vars & MET_U)
+	  met->u[ix][iy][ip] = met->u[ix][iy][ip + 1];
+	if (met->vars & MET_V)
+	  met->v[ix][iy][ip] = met->v[ix][iy][ip + 1];
+	if (met->vars & MET_W)
+	  met->w[ix][iy][ip] = met->w[ix][iy][ip + 1];
+	if (met->vars & MET_H2O)
+	  met->h2o[ix][iy][ip] = met->h2o[ix][iy][ip + 1];
+	if (met->vars & MET_O3)
+	  met->o3[ix][iy][ip] = met->o3[ix][iy][ip + 1];
       }
     }
 }
@@ -774,11 +1307,15 @@ void read_met_geopot(
 
   char line[LEN];
 
-  double data[30], lat, lon, rlat, rlon, rlon_old = -999, rz, ts, z0, z1;
+  double lat, lon, rlat, rlon, rlon_old = -999, rz, ts, z0, z1;
 
-  float help[EX][EY];
+  float (*help)[EY][EP];
 
-  int ip, ip0, ix, ix2, ix3, iy, iy2, n, tx, ty;
+  int ip, ip0, ix, iy, tx, ty;
+
+  /* Check variables... */
+  if (!(met->vars & MET_Z))
+    return;
 
   /* Initialize geopotential heights... */
   for (ix = 0; ix < met->nx; ix++)
@@ -791,6 +1328,7 @@ void read_met_geopot(
     return;
 
   /* Read surface geopotential... */
+#pragma omp critical (geopot)
   if (!init) {
 
     /* Write info... */
@@ -869,37 +1407,108 @@ void read_met_geopot(
     }
 
   /* Smooth fields... */
-  for (ip = 0; ip < met->np; ip++) {
+  ALLOC(help, float,
+	EX * EY * EP);
+#pragma omp taskloop default(none) shared(met,help)
+  for (ix = 0; ix < met->nx; ix++)
+    read_met_median(met, ix, help[ix]);
 
-    /* Median filter... */
-    for (ix = 0; ix < met->nx; ix++)
-      for (iy = 0; iy < met->nx; iy++) {
-	n = 0;
-	for (ix2 = ix - 2; ix2 <= ix + 2; ix2++) {
-	  ix3 = ix2;
-	  if (ix3 < 0)
-	    ix3 += met->nx;
-	  if (ix3 >= met->nx)
-	    ix3 -= met->nx;
-	  for (iy2 = GSL_MAX(iy - 2, 0); iy2 <= GSL_MIN(iy + 2, met->ny - 1);
-	       iy2++)
-	    if (gsl_finite(met->z[ix3][iy2][ip])) {
-	      data[n] = met->z[ix3][iy2][ip];
-	      n++;
-	    }
+  /* Copy data... */
+  for (ix = 0; ix < met->nx; ix++)
+    for (iy = 0; iy < met->ny; iy++)
+      for (ip = 0; ip < met->np; ip++)
+	met->z[ix][iy][ip] = help[ix][iy][ip];
+
+  /* Free... */
+  free(help);
+}
+
+/*****************************************************************************/
+
+void read_met_median(
+  met_t * met,
+  int ix,
+  float help[EY][EP]) {
+
+  /* Median selection network for 25 elements (Paeth, 1990)... */
+  static const int net[99][2] = {
+    {0, 1}, {3, 4}, {2, 4}, {2, 3}, {6, 7}, {5, 7}, {5, 6}, {9, 10}, {8, 10},
+    {8, 9}, {12, 13}, {11, 13}, {11, 12}, {15, 16}, {14, 16}, {14, 15},
+    {18, 19}, {17, 19}, {17, 18}, {21, 22}, {20, 22}, {20, 21}, {23, 24},
+    {2, 5}, {3, 6}, {0, 6}, {0, 3}, {4, 7}, {1, 7}, {1, 4}, {11, 14}, {8, 14},
+    {8, 11}, {12, 15}, {9, 15}, {9, 12}, {13, 16}, {10, 16}, {10, 13},
+    {20, 23}, {17, 23}, {17, 20}, {21, 24}, {18, 24}, {18, 21}, {19, 22},
+    {8, 17}, {9, 18}, {0, 18}, {0, 9}, {10, 19}, {1, 19}, {1, 10}, {11, 20},
+    {2, 20}, {2, 11}, {12, 21}, {3, 21}, {3, 12}, {13, 22}, {4, 22}, {4, 13},
+    {14, 23}, {5, 23}, {5, 14}, {15, 24}, {6, 24}, {6, 15}, {7, 16}, {7, 19},
+    {13, 21}, {15, 23}, {7, 13}, {7, 15}, {1, 9}, {3, 11}, {5, 17}, {11, 17},
+    {9, 17}, {4, 10}, {6, 12}, {7, 14}, {4, 6}, {4, 7}, {12, 14}, {10, 14},
+    {6, 7}, {10, 12}, {6, 10}, {6, 17}, {12, 17}, {7, 17}, {7, 10}, {12, 18},
+    {7, 12}, {10, 18}, {12, 20}, {10, 20}, {10, 12}
+  };
+
+  float data[25], lo, hi, w[25][EP];
+
+  int cnt[EP], i, ip, ix2, ix3, iy, iy2, j, k, n;
+
+  /* Loop over latitudes... */
+  for (iy = 0; iy < met->ny; iy++) {
+
+    /* Collect profiles of the 5x5 window... */
+    for (ip = 0; ip < met->np; ip++)
+      cnt[ip] = 0;
+    n = 0;
+    for (ix2 = ix - 2; ix2 <= ix + 2; ix2++) {
+      ix3 = ix2;
+      if (ix3 < 0)
+	ix3 += met->nx;
+      if (ix3 >= met->nx)
+	ix3 -= met->nx;
+      for (iy2 = GSL_MAX(iy - 2, 0); iy2 <= GSL_MIN(iy + 2, met->ny - 1);
+	   iy2++) {
+	for (ip = 0; ip < met->np; ip++) {
+	  w[n][ip] = met->z[ix3][iy2][ip];
+	  cnt[ip] += gsl_finite(w[n][ip]);
 	}
-	if (n > 0) {
-	  gsl_sort(data, 1, (size_t) n);
-	  help[ix][iy] = (float)
-	    gsl_stats_median_from_sorted_data(data, 1, (size_t) n);
-	} else
-	  help[ix][iy] = GSL_NAN;
+	n++;
       }
+    }
 
-    /* Copy data... */
-    for (ix = 0; ix < met->nx; ix++)
-      for (iy = 0; iy < met->nx; iy++)
-	met->z[ix][iy][ip] = help[ix][iy];
+    /* Apply selection network to all levels at once... */
+    if (n == 25)
+      for (k = 0; k < 99; k++) {
+	float *a = w[net[k][0]], *b = w[net[k][1]];
+	for (ip = 0; ip < met->np; ip++) {
+	  lo = (a[ip] < b[ip] ? a[ip] : b[ip]);
+	  hi = (a[ip] < b[ip] ? b[ip] : a[ip]);
+	  a[ip] = lo;
+	  b[ip] = hi;
+	}
+      }
+
+    /* Get median... */
+    for (ip = 0; ip < met->np; ip++) {
+
+      /* Complete window... */
+      if (cnt[ip] == 25) {
+	help[iy][ip] = w[12][ip];
+	continue;
+      }
+
+      /* Sort valid data of incomplete window... */
+      for (i = k = 0; i < n; i++)
+	if (gsl_finite(w[i][ip])) {
+	  for (j = k++; j > 0 && data[j - 1] > w[i][ip]; j--)
+	    data[j] = data[j - 1];
+	  data[j] = w[i][ip];
+	}
+      if (k > 0)
+	help[iy][ip] = (k % 2 ? data[k / 2]
+			: (float) (0.5 * ((double) data[k / 2 - 1]
+					  + data[k / 2])));
+      else
+	help[iy][ip] = GSL_NAN;
+    }
   }
 }
 
@@ -913,28 +1522,63 @@ void read_met_help(
   float dest[EX][EY][EP],
   float scl) {
 
-  static float help[EX * EY * EP];
+  float *help;
+
+  size_t count[4], start[4];
 
-  int ip, ix, iy, varid;
+  int found = 1, ip, ip0, ix, iy, iy0, iy1, k, ndims = 0, nlev, varid;
 
   /* Check if variable exists... */
-  if (nc_inq_varid(ncid, varname, &varid) != NC_NOERR)
-    if (nc_inq_varid(ncid, varname2, &varid) != NC_NOERR)
-      return;
+#pragma omp critical (netcdf)
+  {
+    if (nc_inq_varid(ncid, varname, &varid) != NC_NOERR)
+      if (nc_inq_varid(ncid, varname2, &varid) != NC_NOERR)
+	found = 0;
+    if (found)
+      NC(nc_inq_varndims(ncid, varid, &ndims));
+  }
+  if (!found)
+    return;
+  if (ndims < 3 || ndims > 4)
+    ERRMSG("Meteorological data must be 3-D or 4-D!");
 
-  /* Read data... */
-  NC(nc_get_var_float(ncid, varid, help));
+  /* Allocate... */
+  ALLOC(help, float,
+	NLEVBLK * EX * EY);
 
-  /* Copy and check data... */
-  for (ix = 0; ix < met->nx; ix++)
-    for (iy = 0; iy < met->ny; iy++)
-      for (ip = 0; ip < met->np; ip++) {
-	dest[ix][iy][ip] = help[(ip * met->ny + iy) * met->nx + ix];
-	if (fabsf(dest[ix][iy][ip]) < 1e14f)
-	  dest[ix][iy][ip] *= scl;
-	else
-	  dest[ix][iy][ip] = GSL_NAN;
-      }
+  /* Loop over blocks of pressure levels... */
+  for (ip0 = 0; ip0 < met->np; ip0 += NLEVBLK) {
+
+    /* Read hyperslab (p, y, x)... */
+    nlev = GSL_MIN(NLEVBLK, met->np - ip0);
+    for (k = 0; k < ndims; k++) {
+      start[k] = 0;
+      count[k] = 1;
+    }
+    start[ndims - 3] = (size_t) ip0;
+    count[ndims - 3] = (size_t) nlev;
+    count[ndims - 2] = (size_t) met->ny;
+    count[ndims - 1] = (size_t) met->nx;
+#pragma omp critical (netcdf)
+    NC(nc_get_vara_float(ncid, varid, start, count, help));
+
+    /* Transpose to (x, y, p) in tiles of latitudes, check and scale... */
+    for (iy0 = 0; iy0 < met->ny; iy0 += NLATBLK) {
+      iy1 = GSL_MIN(iy0 + NLATBLK, met->ny);
+      for (ix = 0; ix < met->nx; ix++)
+	for (iy = iy0; iy < iy1; iy++)
+	  for (ip = 0; ip < nlev; ip++) {
+	    const float val = help[(ip * met->ny + iy) * met->nx + ix];
+	    if (fabsf(val) < 1e14f)
+	      dest[ix][iy][ip0 + ip] = scl * val;
+	    else
+	      dest[ix][iy][ip0 + ip] = GSL_NAN;
+	  }
+    }
+  }
+
+  /* Free... */
+  free(help);
 }
 
 /*****************************************************************************/
@@ -996,6 +1640,7 @@ void read_met_sample(
   help->nx = met->nx;
   help->ny = met->ny;
   help->np = met->np;
+  help->vars = met->vars;
   memcpy(help->lon, met->lon, sizeof(met->lon));
   memcpy(help->lat, met->lat, sizeof(met->lat));
   memcpy(help->p, met->p, sizeof(met->p));
@@ -1006,14 +1651,21 @@ void read_met_sample(
       for (ip = 0; ip < met->np; ip += ctl2->met_dp) {
 	help->ps[ix][iy] = 0;
 	help->pt[ix][iy] = 0;
-	help->z[ix][iy][ip] = 0;
-	help->t[ix][iy][ip] = 0;
-	help->u[ix][iy][ip] = 0;
-	help->v[ix][iy][ip] = 0;
-	help->w[ix][iy][ip] = 0;
+	if (met->vars & MET_Z)
+	  help->z[ix][iy][ip] = 0;
+	if (met->vars & MET_T)
+	  help->t[ix][iy][ip] = 0;
+	if (met->vars & MET_U)
+	  help->u[ix][iy][ip] = 0;
+	if (met->vars & MET_V)
+	  help->v[ix][iy][ip] = 0;
+	if (met->vars & MET_W)
+	  help->w[ix][iy][ip] = 0;
 	help->pv[ix][iy][ip] = 0;
-	help->h2o[ix][iy][ip] = 0;
-	help->o3[ix][iy][ip] = 0;
+	if (met->vars & MET_H2O)
+	  help->h2o[ix][iy][ip] = 0;
+	if (met->vars & MET_O3)
+	  help->o3[ix][iy][ip] = 0;
 	wsum = 0;
 	for (ix2 = ix - ctl2->met_sx + 1; ix2 <= ix + ctl2->met_sx - 1; ix2++) {
 	  ix3 = ix2;
@@ -1031,27 +1683,41 @@ void read_met_sample(
 		* (1.0f - (float) abs(ip - ip2) / (float) ctl2->met_sp);
 	      help->ps[ix][iy] += w * met->ps[ix3][iy2];
 	      help->pt[ix][iy] += w * met->pt[ix3][iy2];
-	      help->z[ix][iy][ip] += w * met->z[ix3][iy2][ip2];
-	      help->t[ix][iy][ip] += w * met->t[ix3][iy2][ip2];
-	      help->u[ix][iy][ip] += w * met->u[ix3][iy2][ip2];
-	      help->v[ix][iy][ip] += w * met->v[ix3][iy2][ip2];
-	      help->w[ix][iy][ip] += w * met->w[ix3][iy2][ip2];
+	      if (met->vars & MET_Z)
+		help->z[ix][iy][ip] += w * met->z[ix3][iy2][ip2];
+	      if (met->vars & MET_T)
+		help->t[ix][iy][ip] += w * met->t[ix3][iy2][ip2];
+	      if (met->vars & MET_U)
+		help->u[ix][iy][ip] += w * met->u[ix3][iy2][ip2];
+	      if (met->vars & MET_V)
+		help->v[ix][iy][ip] += w * met->v[ix3][iy2][ip2];
+	      if (met->vars & MET_W)
+		help->w[ix][iy][ip] += w * met->w[ix3][iy2][ip2];
 	      help->pv[ix][iy][ip] += w * met->pv[ix3][iy2][ip2];
-	      help->h2o[ix][iy][ip] += w * met->h2o[ix3][iy2][ip2];
-	      help->o3[ix][iy][ip] += w * met->o3[ix3][iy2][ip2];
+	      if (met->vars & MET_H2O)
+		help->h2o[ix][iy][ip] += w * met->h2o[ix3][iy2][ip2];
+	      if (met->vars & MET_O3)
+		help->o3[ix][iy][ip] += w * met->o3[ix3][iy2][ip2];
 	      wsum += w;
 	    }
 	}
 	help->ps[ix][iy] /= wsum;
 	help->pt[ix][iy] /= wsum;
-	help->t[ix][iy][ip] /= wsum;
-	help->z[ix][iy][ip] /= wsum;
-	help->u[ix][iy][ip] /= wsum;
-	help->v[ix][iy][ip] /= wsum;
-	help->w[ix][iy][ip] /= wsum;
+	if (met->vars & MET_T)
+	  help->t[ix][iy][ip] /= wsum;
+	if (met->vars & MET_Z)
+	  help->z[ix][iy][ip] /= wsum;
+	if (met->vars & MET_U)
+	  help->u[ix][iy][ip] /= wsum;
+	if (met->vars & MET_V)
+	  help->v[ix][iy][ip] /= wsum;
+	if (met->vars & MET_W)
+	  help->w[ix][iy][ip] /= wsum;
 	help->pv[ix][iy][ip] /= wsum;
-	help->h2o[ix][iy][ip] /= wsum;
-	help->o3[ix][iy][ip] /= wsum;
+	if (met->vars & MET_H2O)
+	  help->h2o[ix][iy][ip] /= wsum;
+	if (met->vars & MET_O3)
+	  help->o3[ix][iy][ip] /= wsum;
       }
     }
   }
@@ -1068,14 +1734,21 @@ void read_met_sample(
       met->np = 0;
       for (ip = 0; ip < help->np; ip += ctl2->met_dp) {
 	met->p[met->np] = help->p[ip];
-	met->z[met->nx][met->ny][met->np] = help->z[ix][iy][ip];
-	met->t[met->nx][met->ny][met->np] = help->t[ix][iy][ip];
-	met->u[met->nx][met->ny][met->np] = help->u[ix][iy][ip];
-	met->v[met->nx][met->ny][met->np] = help->v[ix][iy][ip];
-	met->w[met->nx][met->ny][met->np] = help->w[ix][iy][ip];
+	if (met->vars & MET_Z)
+	  met->z[met->nx][met->ny][met->np] = help->z[ix][iy][ip];
+	if (met->vars & MET_T)
+	  met->t[met->nx][met->ny][met->np] = help->t[ix][iy][ip];
+	if (met->vars & MET_U)
+	  met->u[met->nx][met->ny][met->np] = help->u[ix][iy][ip];
+	if (met->vars & MET_V)
+	  met->v[met->nx][met->ny][met->np] = help->v[ix][iy][ip];
+	if (met->vars & MET_W)
+	  met->w[met->nx][met->ny][met->np] = help->w[ix][iy][ip];
 	met->pv[met->nx][met->ny][met->np] = help->pv[ix][iy][ip];
-	met->h2o[met->nx][met->ny][met->np] = help->h2o[ix][iy][ip];
-	met->o3[met->nx][met->ny][met->np] = help->o3[ix][iy][ip];
+	if (met->vars & MET_H2O)
+	  met->h2o[met->nx][met->ny][met->np] = help->h2o[ix][iy][ip];
+	if (met->vars & MET_O3)
+	  met->o3[met->nx][met->ny][met->np] = help->o3[ix][iy][ip];
 	met->np++;
       }
       met->ny++;
@@ -34,7 +34,7 @@ void analyze_avk(
   const int *ipa,
   const gsl_matrix *avk) {
 
-  static atm_t atm_cont, atm_res;
+  atm_t *atm_cont, *atm_res;
 
   size_t i, n0[NQ], n1[NQ];
 
@@ -52,33 +52,43 @@ void analyze_avk(
     }
   }
 
+  /* Allocate... */
+  ALLOC(atm_cont, atm_t, 1);
+  ALLOC(atm_res, atm_t, 1);
+
   /* Initialize... */
-  copy_atm(ctl, &atm_cont, atm, 1);
-  copy_atm(ctl, &atm_res, atm, 1);
+  copy_atm(ctl, atm_cont, atm, 1);
+  copy_atm(ctl, atm_res, atm, 1);
 
   /* Analyze quantities... */
-  analyze_avk_quantity(avk, IDXP, ipa, n0, n1, atm_cont.p, atm_res.p);
-  analyze_avk_quantity(avk, IDXT, ipa, n0, n1, atm_cont.t, atm_res.t);
+  analyze_avk_quantity(avk, IDXP, ipa, n0, n1, atm_cont->p, atm_res->p);
+  analyze_avk_quantity(avk, IDXT, ipa, n0, n1, atm_cont->t, atm_res->t);
   for (int ig = 0; ig < ctl->ng; ig++)
     analyze_avk_quantity(avk, IDXQ(ig), ipa, n0, n1,
-			 atm_cont.q[ig], atm_res.q[ig]);
+			 atm_cont->q[ig], atm_res->q[ig]);
   for (int iw = 0; iw < ctl->nw; iw++)
     analyze_avk_quantity(avk, IDXK(iw), ipa, n0, n1,
-			 atm_cont.k[iw], atm_res.k[iw]);
-  analyze_avk_quantity(avk, IDXCLZ, ipa, n0, n1, &atm_cont.clz, &atm_res.clz);
-  analyze_avk_quantity(avk, IDXCLDZ, ipa, n0, n1, &atm_cont.cldz,
-		       &atm_res.cldz);
+			 atm_cont->k[iw], atm_res->k[iw]);
+  analyze_avk_quantity(avk, IDXCLZ, ipa, n0, n1, &atm_cont->clz,
+		       &atm_res->clz);
+  analyze_avk_quantity(avk, IDXCLDZ, ipa, n0, n1, &atm_cont->cldz,
+		       &atm_res->cldz);
   for (int icl = 0; icl < ctl->ncl; icl++)
     analyze_avk_quantity(avk, IDXCLK(icl), ipa, n0, n1,
-			 &atm_cont.clk[icl], &atm_res.clk[icl]);
-  analyze_avk_quantity(avk, IDXSFT, ipa, n0, n1, &atm_cont.sft, &atm_res.sft);
+			 &atm_cont->clk[icl], &atm_res->clk[icl]);
+  analyze_avk_quantity(avk, IDXSFT, ipa, n0, n1, &atm_cont->sft,
+		       &atm_res->sft);
   for (int isf = 0; isf < ctl->nsf; isf++)
     analyze_avk_quantity(avk, IDXSFEPS(isf), ipa, n0, n1,
-			 &atm_cont.sfeps[isf], &atm_res.sfeps[isf]);
+			 &atm_cont->sfeps[isf], &atm_res->sfeps[isf]);
 
   /* Write results to disk... */
-  write_atm(ret->dir, "atm_cont.tab", ctl, &atm_cont);
-  write_atm(ret->dir, "atm_res.tab", ctl, &atm_res);
+  write_atm(ret->dir, "atm_cont.tab", ctl, atm_cont);
+  write_atm(ret->dir, "atm_res.tab", ctl, atm_res);
+
+  /* Free... */
+  free(atm_cont);
+  free(atm_res);
 }
 
 /*****************************************************************************/
@@ -1135,6 +1145,18 @@ void climatology(
 
 /*****************************************************************************/
 
+int cmp_tbl_gas_index(
+  const void *a,
+  const void *b) {
+
+  const double fa = ((const tbl_gas_index_t *) a)->freq;
+  const double fb = ((const tbl_gas_index_t *) b)->freq;
+
+  return (fa > fb) - (fa < fb);
+}
+
+/*****************************************************************************/
+
 double cos_sza(
   const double sec,
   const double lon,
@@ -1215,6 +1237,26 @@ double ctmco2(
   const double t,
   const double u) {
 
+  double c[3];
+
+  /* Get spectral coefficients... */
+  ctmco2_coeff(nu, c);
+
+  /* Get CO2 continuum absorption... */
+  const double dt230 = t - 230;
+  const double dt260 = t - 260;
+  const double dt296 = t - 296;
+  const double ctw = dt260 * dt296 * c[0] - dt230 * dt296 * c[1]
+    + dt230 * dt260 * c[2];
+  return u / NA / 1000 * p / P0 * ctw;
+}
+
+/*****************************************************************************/
+
+void ctmco2_coeff(
+  const double nu,
+  double *c) {
+
   static const double co2296[2001] =
     { 9.3388e-5, 9.7711e-5, 1.0224e-4, 1.0697e-4,
     1.1193e-4, 1.1712e-4, 1.2255e-4, 1.2824e-4, 1.3419e-4, 1.4043e-4,
@@ -2049,7 +2091,7 @@ double ctmco2(
     .12584
   };
 
-  /* Get CO2 continuum absorption... */
+  /* Get CO2 continuum coefficients... */
   const double xw = nu / 2 + 1;
   if (xw >= 1 && xw < 2001) {
     const int iw = (int) xw;
@@ -2058,16 +2100,11 @@ double ctmco2(
     const double cw296 = ew * co2296[iw - 1] + dw * co2296[iw];
     const double cw260 = ew * co2260[iw - 1] + dw * co2260[iw];
     const double cw230 = ew * co2230[iw - 1] + dw * co2230[iw];
-    const double dt230 = t - 230;
-    const double dt260 = t - 260;
-    const double dt296 = t - 296;
-    const double ctw =
-      dt260 * 5.050505e-4 * dt296 * cw230 -
-      dt230 * 9.259259e-4 * dt296 * cw260 +
-      dt230 * 4.208754e-4 * dt260 * cw296;
-    return u / NA / 1000 * p / P0 * ctw;
+    c[0] = 5.050505e-4 * cw230;
+    c[1] = 9.259259e-4 * cw260;
+    c[2] = 4.208754e-4 * cw296;
   } else
-    return 0;
+    c[0] = c[1] = c[2] = 0;
 }
 
 /*****************************************************************************/
@@ -2079,6 +2116,25 @@ double ctmh2o(
   const double q,
   const double u) {
 
+  double c[5];
+
+  /* Get spectral coefficients... */
+  ctmh2o_coeff(nu, c);
+
+  /* Get H2O continuum absorption... */
+  const double ctwslf = c[0] * exp(c[1] * (296 - t));
+  const double a1 = c[3] * u * tanh(c[4] / t);
+  const double a2 = 296 / t;
+  const double a3 = p / P0 * (q * ctwslf + (1 - q) * c[2]) * 1e-20;
+  return a1 * a2 * a3;
+}
+
+/*****************************************************************************/
+
+void ctmh2o_coeff(
+  const double nu,
+  double *c) {
+
   static const double h2o296[2001] =
     { .17, .1695, .172, .168, .1687, .1624, .1606,
     .1508, .1447, .1344, .1214, .1133, .1009, .09217, .08297, .06989,
@@ -3091,7 +3147,7 @@ double ctmh2o(
 
   double sfac;
 
-  /* Get H2O continuum absorption... */
+  /* Get H2O continuum coefficients... */
   const double xw = nu / 10 + 1;
   if (xw >= 1 && xw < 2001) {
     const int iw = (int) xw;
@@ -3108,18 +3164,16 @@ double ctmh2o(
       const double dx = xx - ix;
       sfac = (1 - dx) * xfcrev[ix] + dx * xfcrev[ix + 1];
     }
-    const double ctwslf =
-      sfac * cw296 * pow(cw260 / cw296, (296 - t) / (296 - 260));
     const double vf2 = POW2(nu - 370);
     const double vf6 = POW3(vf2);
     const double fscal = 36100 / (vf2 + vf6 * 1e-8 + 36100) * -.25 + 1;
-    const double ctwfrn = cwfrn * fscal;
-    const double a1 = nu * u * tanh(.7193876 / t * nu);
-    const double a2 = 296 / t;
-    const double a3 = p / P0 * (q * ctwslf + (1 - q) * ctwfrn) * 1e-20;
-    return a1 * a2 * a3;
+    c[0] = sfac * cw296;
+    c[1] = (cw260 > 0 && cw296 > 0 ? log(cw260 / cw296) / (296 - 260) : 0);
+    c[2] = cwfrn * fscal;
+    c[3] = nu;
+    c[4] = .7193876 * nu;
   } else
-    return 0;
+    c[0] = c[1] = c[2] = c[3] = c[4] = 0;
 }
 
 /*****************************************************************************/
@@ -3129,6 +3183,24 @@ double ctmn2(
   const double p,
   const double t) {
 
+  const double t0 = 273.0, tr = 296.0;
+
+  double c[2];
+
+  /* Get spectral coefficients... */
+  ctmn2_coeff(nu, c);
+
+  /* Compute absorption coefficient... */
+  return c[0] * POW2(p / P0 * t0 / t) * exp(c[1] * (1 / tr - 1 / t))
+    * (N2 + (1 - N2) * (1.294 - 0.4545 * t / tr));
+}
+
+/*****************************************************************************/
+
+void ctmn2_coeff(
+  const double nu,
+  double *c) {
+
   static const double ba[98] =
     { 0., 4.45e-8, 5.22e-8, 6.46e-8, 7.75e-8, 9.03e-8,
     1.06e-7, 1.21e-7, 1.37e-7, 1.57e-7, 1.75e-7, 2.01e-7, 2.3e-7,
@@ -3173,22 +3245,18 @@ double ctmn2(
     2560., 2565., 2570., 2575., 2580., 2585., 2590., 2595., 2600., 2605.
   };
 
-  const double t0 = 273.0, tr = 296.0;
-
   /* Check wavenumber range... */
-  if (nu < nua[0] || nu > nua[97])
-    return 0;
+  if (nu < nua[0] || nu > nua[97]) {
+    c[0] = c[1] = 0;
+    return;
+  }
 
   /* Interpolate B and beta... */
   const int idx = locate_reg(nua, 98, nu);
   const double b =
     1e6 * LIN(nua[idx], ba[idx], nua[idx + 1], ba[idx + 1], nu);
-  const double beta =
-    LIN(nua[idx], betaa[idx], nua[idx + 1], betaa[idx + 1], nu);
-
-  /* Compute absorption coefficient... */
-  return 0.1 * POW2(p / P0 * t0 / t) * exp(beta * (1 / tr - 1 / t))
-    * N2 * b * (N2 + (1 - N2) * (1.294 - 0.4545 * t / tr));
+  c[0] = 0.1 * N2 * b;
+  c[1] = LIN(nua[idx], betaa[idx], nua[idx + 1], betaa[idx + 1], nu);
 }
 
 /*****************************************************************************/
@@ -3198,6 +3266,23 @@ double ctmo2(
   const double p,
   const double t) {
 
+  const double t0 = 273, tr = 296;
+
+  double c[2];
+
+  /* Get spectral coefficients... */
+  ctmo2_coeff(nu, c);
+
+  /* Compute absorption coefficient... */
+  return c[0] * POW2(p / P0 * t0 / t) * exp(c[1] * (1 / tr - 1 / t));
+}
+
+/*****************************************************************************/
+
+void ctmo2_coeff(
+  const double nu,
+  double *c) {
+
   static const double ba[90] =
     { 0., .061, .074, .084, .096, .12, .162, .208, .246,
     .285, .314, .38, .444, .5, .571, .673, .768, .853, .966, 1.097,
@@ -3237,20 +3322,17 @@ double ctmo2(
     1800., 1805.
   };
 
-  const double t0 = 273, tr = 296;
-
   /* Check wavenumber range... */
-  if (nu < nua[0] || nu > nua[89])
-    return 0;
+  if (nu < nua[0] || nu > nua[89]) {
+    c[0] = c[1] = 0;
+    return;
+  }
 
   /* Interpolate B and beta... */
   const int idx = locate_reg(nua, 90, nu);
   const double b = LIN(nua[idx], ba[idx], nua[idx + 1], ba[idx + 1], nu);
-  const double beta =
-    LIN(nua[idx], betaa[idx], nua[idx + 1], betaa[idx + 1], nu);
-
-  /* Compute absorption coefficient... */
-  return 0.1 * POW2(p / P0 * t0 / t) * exp(beta * (1 / tr - 1 / t)) * O2 * b;
+  c[0] = 0.1 * O2 * b;
+  c[1] = LIN(nua[idx], betaa[idx], nua[idx + 1], betaa[idx + 1], nu);
 }
 
 /*****************************************************************************/
@@ -3412,82 +3494,144 @@ void formod(
   atm_t *atm,
   obs_t *obs) {
 
-  int *mask;
-
-  /* Allocate... */
-  ALLOC(mask, int,
-	ND * NR);
+  formod_geo(ctl, tbl, atm, obs, NULL);
+}
 
-  /* Save observation mask... */
-  for (int id = 0; id < ctl->nd; id++)
-    for (int ir = 0; ir < obs->nr; ir++)
-      mask[id * NR + ir] = !isfinite(obs->rad[id][ir]);
+/*****************************************************************************/
 
-  /* Hydrostatic equilibrium... */
-  hydrostatic(ctl, atm);
+void formod_continua(
+  const ctl_t *ctl,
+  const tbl_t *tbl,
+  const los_t *los,
+  const int ip,
+  double *beta) {
 
-  /* CGA or EGA forward model... */
-  if (ctl->formod == 0 || ctl->formod == 1)
-    for (int ir = 0; ir < obs->nr; ir++)
-      formod_pencil(ctl, tbl, atm, obs, ir);
+  const double p = los->p[ip], t = los->t[ip];
 
-  /* Call RFM... */
-  else if (ctl->formod == 2)
-    formod_rfm(ctl, atm, obs);
+  /* Extinction... */
+  for (int id = 0; id < ctl->nd; id++)
+    beta[id] = los->k[ip][id];
 
-  /* Apply field-of-view convolution... */
-  formod_fov(ctl, obs);
+  /* CO2 continuum... */
+  if (ctl->ctm_co2 && ctl->ig_co2 >= 0) {
+    const double a =
+      los->u[ip][ctl->ig_co2] / NA / 1000 * p / P0 / los->ds[ip];
+    const double a230 = a * (t - 260) * (t - 296);
+    const double a260 = -a * (t - 230) * (t - 296);
+    const double a296 = a * (t - 230) * (t - 260);
+#pragma omp simd
+    for (int id = 0; id < ctl->nd; id++)
+      beta[id] += a230 * tbl->ctm_co2[0][id] + a260 * tbl->ctm_co2[1][id]
+	+ a296 * tbl->ctm_co2[2][id];
+  }
 
-  /* Convert radiance to brightness temperature... */
-  if (ctl->write_bbt)
+  /* H2O continuum... */
+  if (ctl->ctm_h2o && ctl->ig_h2o >= 0) {
+    const double q = los->q[ip][ctl->ig_h2o];
+    const double a =
+      los->u[ip][ctl->ig_h2o] * 296 / t * p / P0 * 1e-20 / los->ds[ip];
+    const double dt = 296 - t;
+#pragma omp simd
     for (int id = 0; id < ctl->nd; id++)
-      for (int ir = 0; ir < obs->nr; ir++)
-	obs->rad[id][ir] = BRIGHT(obs->rad[id][ir], ctl->nu[id]);
+      beta[id] += a * tbl->ctm_h2o[3][id] * tanh(tbl->ctm_h2o[4][id] / t)
+	* (q * tbl->ctm_h2o[0][id] * exp(tbl->ctm_h2o[1][id] * dt)
+	   + (1 - q) * tbl->ctm_h2o[2][id]);
+  }
 
-  /* Apply observation mask... */
-  for (int id = 0; id < ctl->nd; id++)
-    for (int ir = 0; ir < obs->nr; ir++)
-      if (mask[id * NR + ir])
-	obs->rad[id][ir] = NAN;
+  /* N2 continuum... */
+  if (ctl->ctm_n2) {
+    const double a = POW2(p / P0 * 273 / t)
+      * (N2 + (1 - N2) * (1.294 - 0.4545 * t / 296));
+    const double dt = 1 / 296. - 1 / t;
+#pragma omp simd
+    for (int id = 0; id < ctl->nd; id++)
+      beta[id] += a * tbl->ctm_n2[0][id] * exp(tbl->ctm_n2[1][id] * dt);
+  }
 
-  /* Free... */
-  free(mask);
+  /* O2 continuum... */
+  if (ctl->ctm_o2) {
+    const double a = POW2(p / P0 * 273 / t);
+    const double dt = 1 / 296. - 1 / t;
+#pragma omp simd
+    for (int id = 0; id < ctl->nd; id++)
+      beta[id] += a * tbl->ctm_o2[0][id] * exp(tbl->ctm_o2[1][id] * dt);
+  }
 }
 
 /*****************************************************************************/
 
-void formod_continua(
+void formod_continua_tl(
   const ctl_t *ctl,
+  const tbl_t *tbl,
   const los_t *los,
   const int ip,
-  double *beta) {
+  const int id,
+  double *beta,
+  double *dbeta) {
+
+  const double p = los->p[ip], t = los->t[ip], ds = los->ds[ip];
 
   /* Extinction... */
-  for (int id = 0; id < ctl->nd; id++)
-    beta[id] = los->k[ip][id];
+  *beta = los->k[ip][id];
+  for (int i = 0; i < 5; i++)
+    dbeta[i] = 0;
 
   /* CO2 continuum... */
-  if (ctl->ctm_co2 && ctl->ig_co2 >= 0)
-    for (int id = 0; id < ctl->nd; id++)
-      beta[id] += ctmco2(ctl->nu[id], los->p[ip], los->t[ip],
-			 los->u[ip][ctl->ig_co2]) / los->ds[ip];
+  if (ctl->ctm_co2 && ctl->ig_co2 >= 0) {
+    const double c0 = tbl->ctm_co2[0][id], c1 = tbl->ctm_co2[1][id];
+    const double c2 = tbl->ctm_co2[2][id];
+    const double u = los->u[ip][ctl->ig_co2];
+    const double a = u / NA / 1000 * p / P0 / ds;
+    const double poly = (t - 260) * (t - 296) * c0
+      - (t - 230) * (t - 296) * c1 + (t - 230) * (t - 260) * c2;
+    *beta += a * poly;
+    dbeta[0] += a * ((2 * t - 556) * c0 - (2 * t - 526) * c1
+		     + (2 * t - 490) * c2);
+    dbeta[1] += u / NA / 1000 / P0 / ds * poly;
+    dbeta[2] += p / NA / 1000 / P0 / ds * poly;
+  }
 
   /* H2O continuum... */
-  if (ctl->ctm_h2o && ctl->ig_h2o >= 0)
-    for (int id = 0; id < ctl->nd; id++)
-      beta[id] += ctmh2o(ctl->nu[id], los->p[ip], los->t[ip],
-			 los->q[ip][ctl->ig_h2o], los->u[ip][ctl->ig_h2o])
-	/ los->ds[ip];
+  if (ctl->ctm_h2o && ctl->ig_h2o >= 0) {
+    const double c0 = tbl->ctm_h2o[0][id], c1 = tbl->ctm_h2o[1][id];
+    const double c2 = tbl->ctm_h2o[2][id], c3 = tbl->ctm_h2o[3][id];
+    const double c4 = tbl->ctm_h2o[4][id];
+    const double q = los->q[ip][ctl->ig_h2o];
+    const double u = los->u[ip][ctl->ig_h2o];
+    const double a = u * 296 / t * p / P0 * 1e-20 / ds;
+    const double th = tanh(c4 / t);
+    const double ex = exp(c1 * (296 - t));
+    const double x = q * c0 * ex + (1 - q) * c2;
+    const double b = a * c3 * th * x;
+    *beta += b;
+    dbeta[0] += -b / t - a * c3 * (1 - th * th) * c4 / (t * t)
+      * x - a * c3 * th * q * c0 * c1 * ex;
+    dbeta[1] += u * 296 / t / P0 * 1e-20 / ds * c3 * th * x;
+    dbeta[3] += 296 / t * p / P0 * 1e-20 / ds * c3 * th * x;
+    dbeta[4] += a * c3 * th * (c0 * ex - c2);
+  }
 
   /* N2 continuum... */
-  if (ctl->ctm_n2)
-    for (int id = 0; id < ctl->nd; id++)
-      beta[id] += ctmn2(ctl->nu[id], los->p[ip], los->t[ip]);
+  if (ctl->ctm_n2) {
+    const double f = N2 + (1 - N2) * (1.294 - 0.4545 * t / 296);
+    const double e = tbl->ctm_n2[0][id]
+      * exp(tbl->ctm_n2[1][id] * (1 / 296. - 1 / t));
+    const double a = POW2(p / P0 * 273 / t);
+    *beta += a * f * e;
+    dbeta[0] += e * (a * f * (tbl->ctm_n2[1][id] / (t * t) - 2 / t)
+		     - a * (1 - N2) * 0.4545 / 296);
+    dbeta[1] += 2 * p * POW2(273 / (P0 * t)) * f * e;
+  }
 
   /* O2 continuum... */
-  if (ctl->ctm_o2)
-    for (int id = 0; id < ctl->nd; id++)
-      beta[id] += ctmo2(ctl->nu[id], los->p[ip], los->t[ip]);
+  if (ctl->ctm_o2) {
+    const double e = tbl->ctm_o2[0][id]
+      * exp(tbl->ctm_o2[1][id] * (1 / 296. - 1 / t));
+    const double a = POW2(p / P0 * 273 / t);
+    *beta += a * e;
+    dbeta[0] += a * e * (tbl->ctm_o2[1][id] / (t * t) - 2 / t);
+    dbeta[1] += 2 * p * POW2(273 / (P0 * t)) * e;
+  }
 }
 
 /*****************************************************************************/
@@ -3557,20 +3701,74 @@ void formod_fov(
 
 /*****************************************************************************/
 
+void formod_geo(
+  const ctl_t *ctl,
+  const tbl_t *tbl,
+  atm_t *atm,
+  obs_t *obs,
+  const geo_t *geo) {
+
+  static int *mask = NULL;
+#pragma omp threadprivate(mask)
+
+  /* Allocate (once per thread)... */
+  if (mask == NULL)
+    ALLOC(mask, int,
+	  ND * NR);
+
+  /* Save observation mask... */
+  for (int id = 0; id < ctl->nd; id++)
+    for (int ir = 0; ir < obs->nr; ir++)
+      mask[id * NR + ir] = !isfinite(obs->rad[id][ir]);
+
+  /* Hydrostatic equilibrium... */
+  hydrostatic(ctl, atm);
+
+  /* CGA or EGA forward model... */
+  if (ctl->formod == 0 || ctl->formod == 1)
+    for (int ir = 0; ir < obs->nr; ir++)
+      formod_pencil(ctl, tbl, atm, obs, ir,
+		    (geo != NULL && !ctl->refrac) ? &geo[ir] : NULL);
+
+  /* Call RFM... */
+  else if (ctl->formod == 2)
+    formod_rfm(ctl, atm, obs);
+
+  /* Apply field-of-view convolution... */
+  formod_fov(ctl, obs);
+
+  /* Convert radiance to brightness temperature... */
+  if (ctl->write_bbt)
+    for (int id = 0; id < ctl->nd; id++)
+      for (int ir = 0; ir < obs->nr; ir++)
+	obs->rad[id][ir] = BRIGHT(obs->rad[id][ir], ctl->nu[id]);
+
+  /* Apply observation mask... */
+  for (int id = 0; id < ctl->nd; id++)
+    for (int ir = 0; ir < obs->nr; ir++)
+      if (mask[id * NR + ir])
+	obs->rad[id][ir] = NAN;
+}
+
+/*****************************************************************************/
+
 void formod_pencil(
   const ctl_t *ctl,
   const tbl_t *tbl,
   const atm_t *atm,
   obs_t *obs,
-  const int ir) {
+  const int ir,
+  const geo_t *geo) {
 
-  los_t *los;
+  static los_t *los = NULL;
+#pragma omp threadprivate(los)
 
   double beta_ctm[ND], rad[ND], tau[ND], tau_refl[ND],
     tau_path[ND][NG], tau_gas[ND], x0[3], x1[3];
 
-  /* Allocate... */
-  ALLOC(los, los_t, 1);
+  /* Allocate (once per thread)... */
+  if (los == NULL)
+    ALLOC(los, los_t, 1);
 
   /* Initialize... */
   for (int id = 0; id < ctl->nd; id++) {
@@ -3581,7 +3779,10 @@ void formod_pencil(
   }
 
   /* Raytracing... */
-  raytrace(ctl, atm, obs, los, ir);
+  if (geo != NULL)
+    raytrace_geo(ctl, atm, geo, los);
+  else
+    raytrace(ctl, atm, obs, los, ir);
 
   /* Loop over LOS points... */
   for (int ip = 0; ip < los->np; ip++) {
@@ -3593,7 +3794,7 @@ void formod_pencil(
       intpol_tbl_ega(ctl, tbl, los, ip, tau_path, tau_gas);
 
     /* Get continuum absorption... */
-    formod_continua(ctl, los, ip, beta_ctm);
+    formod_continua(ctl, tbl, los, ip, beta_ctm);
 
     /* Compute Planck function... */
     formod_srcfunc(ctl, tbl, los->t[ip], los->src[ip]);
@@ -3610,7 +3811,8 @@ void formod_pencil(
 
 	/* Compute path transmittance... */
 	tau[id] *= (1 - los->eps[ip][id]);
-      }
+      } else
+	los->eps[ip][id] = 0;
   }
 
   /* Check whether LOS hit the ground... */
@@ -3685,9 +3887,6 @@ void formod_pencil(
     obs->rad[id][ir] = rad[id];
     obs->tau[id][ir] = tau[id];
   }
-
-  /* Free... */
-  free(los);
 }
 
 /*****************************************************************************/
@@ -3850,6 +4049,42 @@ void formod_srcfunc(
 
 /*****************************************************************************/
 
+void free_tbl(
+  const ctl_t *ctl,
+  tbl_t *tbl) {
+
+  /* Check pointer... */
+  if (!tbl)
+    return;
+
+  /* Free table blocks (mapped data is not freed)... */
+  for (int id = 0; id < ctl->nd; id++)
+    for (int ig = 0; ig < ctl->ng; ig++) {
+      if (!tbl->map[ig]) {
+	free(tbl->u[id][ig]);
+	free(tbl->eps[id][ig]);
+      }
+      free(tbl->ugd[id][ig]);
+      free(tbl->epsgd[id][ig]);
+      free(tbl->ugds[id][ig]);
+      free(tbl->epsgds[id][ig]);
+      free(tbl->uq[id][ig]);
+      free(tbl->epsq[id][ig]);
+      free(tbl->uqs[id][ig]);
+      free(tbl->epsqs[id][ig]);
+    }
+
+  /* Unmap memory-mapped table files... */
+  for (int ig = 0; ig < ctl->ng; ig++)
+    if (tbl->map[ig])
+      munmap(tbl->map[ig], tbl->mapsize[ig]);
+
+  /* Free... */
+  free(tbl);
+}
+
+/*****************************************************************************/
+
 void geo2cart(
   const double z,
   const double lon,
@@ -3870,6 +4105,24 @@ void geo2cart(
 
 /*****************************************************************************/
 
+uint64_t hash_fnv1a(
+  const void *data,
+  const size_t n,
+  uint64_t hash) {
+
+  const unsigned char *c = (const unsigned char *) data;
+
+  /* Apply FNV-1a hash function... */
+  for (size_t i = 0; i < n; i++) {
+    hash ^= c[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+/*****************************************************************************/
+
 void hydrostatic(
   const ctl_t *ctl,
   atm_t *atm) {
@@ -3969,13 +4222,38 @@ void idx2name(
 
 /*****************************************************************************/
 
+void init_ctm(
+  const ctl_t *ctl,
+  tbl_t *tbl) {
+
+  double c[5];
+
+  /* Get spectral coefficients of continua for each channel... */
+  for (int id = 0; id < ctl->nd; id++) {
+    ctmco2_coeff(ctl->nu[id], c);
+    for (int i = 0; i < 3; i++)
+      tbl->ctm_co2[i][id] = c[i];
+    ctmh2o_coeff(ctl->nu[id], c);
+    for (int i = 0; i < 5; i++)
+      tbl->ctm_h2o[i][id] = c[i];
+    ctmn2_coeff(ctl->nu[id], c);
+    for (int i = 0; i < 2; i++)
+      tbl->ctm_n2[i][id] = c[i];
+    ctmo2_coeff(ctl->nu[id], c);
+    for (int i = 0; i < 2; i++)
+      tbl->ctm_o2[i][id] = c[i];
+  }
+}
+
+/*****************************************************************************/
+
 void init_srcfunc(
   const ctl_t *ctl,
   tbl_t *tbl) {
 
   char filename[2 * LEN];
 
-  double f[NSHAPE], nu[NSHAPE];
+  double f[NSHAPE], nu[NSHAPE], sr[TBLNS];
 
   int n;
 
@@ -3983,6 +4261,10 @@ void init_srcfunc(
   LOG(1, "Initialize source function table...");
   LOG(2, "Number of data points: %d", TBLNS);
 
+  /* Set temperatures... */
+  for (int it = 0; it < TBLNS; it++)
+    tbl->st[it] = LIN(0.0, TMIN, TBLNS - 1.0, TMAX, (double) it);
+
   /* Loop over channels... */
   for (int id = 0; id < ctl->nd; id++) {
 
@@ -3990,29 +4272,70 @@ void init_srcfunc(
     sprintf(filename, "%s_%.4f.filt", ctl->tblbase, ctl->nu[id]);
     read_shape(filename, nu, f, &n);
 
-    /* Get minimum grid spacing... */
-    double dnu = 1.0;
-    for (int i = 1; i < n; i++)
-      dnu = MIN(dnu, nu[i] - nu[i - 1]);
-
-    /* Compute source function table... */
-#pragma omp parallel for default(none) shared(ctl,tbl,id,nu,f,n,dnu)
-    for (int it = 0; it < TBLNS; it++) {
-
-      /* Set temperature... */
-      tbl->st[it] = LIN(0.0, TMIN, TBLNS - 1.0, TMAX, (double) it);
+    /* Get hash of filter function and temperature grid... */
+    const double tgrid[3] = { TMIN, TMAX, TBLNS };
+    uint64_t hash = hash_fnv1a(&n, sizeof(int), 14695981039346656037ULL);
+    hash = hash_fnv1a(nu, (size_t) n * sizeof(double), hash);
+    hash = hash_fnv1a(f, (size_t) n * sizeof(double), hash);
+    hash = hash_fnv1a(tgrid, sizeof(tgrid), hash);
+
+    /* Read source function from cache... */
+    char cachefile[3 * LEN];
+    sprintf(cachefile, "%s/srcfunc_%016llx.bin", ctl->srccache,
+	    (unsigned long long) hash);
+    if (ctl->srccache[0] == '-' || read_srcfunc(cachefile, hash, sr) != 0) {
+
+      /* Get minimum grid spacing... */
+      double dnu = 1.0;
+      for (int i = 1; i < n; i++)
+	dnu = MIN(dnu, nu[i] - nu[i - 1]);
+
+      /* Get filter weights and Planck factors on the fine grid... */
+      int nf = 0;
+      for (double fnu = nu[0]; fnu <= nu[n - 1]; fnu += dnu)
+	nf++;
+      double *w, *c1, *c2, fsum = 0;
+      ALLOC(w, double,
+	    nf);
+      ALLOC(c1, double,
+	    nf);
+      ALLOC(c2, double,
+	    nf);
+      int i = 0, j = 0;
+      for (double fnu = nu[0]; fnu <= nu[n - 1] && j < nf; fnu += dnu, j++) {
+	while (i < n - 2 && nu[i + 1] <= fnu)
+	  i++;
+	w[j] = LIN(nu[i], f[i], nu[i + 1], f[i + 1], fnu);
+	c1[j] = C1 * POW3(fnu);
+	c2[j] = C2 * fnu;
+	fsum += w[j];
+      }
 
       /* Integrate Planck function... */
-      double fsum = tbl->sr[it][id] = 0;
-      for (double fnu = nu[0]; fnu <= nu[n - 1]; fnu += dnu) {
-	const int i = locate_irr(nu, n, fnu);
-	const double ff = LIN(nu[i], f[i], nu[i + 1], f[i + 1], fnu);
-	fsum += ff;
-	tbl->sr[it][id] += ff * PLANCK(tbl->st[it], fnu);
+#pragma omp parallel for default(none) shared(tbl,sr,w,c1,c2,nf,fsum)
+      for (int it = 0; it < TBLNS; it++) {
+	const double tinv = 1.0 / tbl->st[it];
+	double sum = 0;
+#pragma omp simd reduction(+:sum)
+	for (int jf = 0; jf < nf; jf++)
+	  sum += w[jf] * c1[jf] / expm1(c2[jf] * tinv);
+	sr[it] = sum / fsum;
       }
-      tbl->sr[it][id] /= fsum;
+
+      /* Free... */
+      free(w);
+      free(c1);
+      free(c2);
+
+      /* Write source function to cache... */
+      if (ctl->srccache[0] != '-')
+	write_srcfunc(cachefile, hash, sr);
     }
 
+    /* Copy source function... */
+    for (int it = 0; it < TBLNS; it++)
+      tbl->sr[it][id] = sr[it];
+
     /* Write info... */
     LOG(2,
 	"channel= %.4f cm^-1 | T= %g ... %g K | B= %g ... %g W/(m^2 sr cm^-1)",
@@ -4023,40 +4346,306 @@ void init_srcfunc(
 
 /*****************************************************************************/
 
-void intpol_atm(
-  const ctl_t *ctl,
-  const atm_t *atm,
-  const double z,
-  double *p,
-  double *t,
-  double *q,
-  double *k) {
+int init_tbl_block(
+  tbl_t *tbl,
+  const int id,
+  const int ig,
+  const float *su,
+  const float *seps) {
 
-  /* Get array index... */
-  const int ip = locate_irr(atm->z, atm->np, z);
+  /* Get size of table block... */
+  int n = 0;
+  tbl->ntab[id][ig] = 0;
+  for (int ip = 0; ip < tbl->np[id][ig]; ip++)
+    for (int it = 0; it < tbl->nt[id][ig][ip]; it++) {
+      tbl->itab[id][ig][ip][it] = tbl->ntab[id][ig]++;
+      tbl->off[id][ig][ip][it] = n;
+      n += MAX(tbl->nu[id][ig][ip][it], 0);
+    }
 
-  /* Interpolate... */
-  *p = LOGY(atm->z[ip], atm->p[ip], atm->z[ip + 1], atm->p[ip + 1], z);
-  *t = LIN(atm->z[ip], atm->t[ip], atm->z[ip + 1], atm->t[ip + 1], z);
-  for (int ig = 0; ig < ctl->ng; ig++)
-    q[ig] =
-      LIN(atm->z[ip], atm->q[ig][ip], atm->z[ip + 1], atm->q[ig][ip + 1], z);
-  for (int iw = 0; iw < ctl->nw; iw++)
-    k[iw] =
-      LIN(atm->z[ip], atm->k[iw][ip], atm->z[ip + 1], atm->k[iw][ip + 1], z);
-}
+  /* Check for offsets only... */
+  if (!su || !seps)
+    return n;
 
-/*****************************************************************************/
+  /* Check for empty block... */
+  tbl->u[id][ig] = tbl->eps[id][ig] = NULL;
+  if (n <= 0)
+    return n;
 
-void intpol_tbl_cga(
-  const ctl_t *ctl,
-  const tbl_t *tbl,
+  /* Allocate... */
+  ALLOC(tbl->u[id][ig], float,
+	n);
+  ALLOC(tbl->eps[id][ig], float,
+	n);
+
+  /* Copy data... */
+  for (int ip = 0; ip < tbl->np[id][ig]; ip++)
+    for (int it = 0; it < tbl->nt[id][ig][ip]; it++) {
+      const size_t s = (size_t) ((ip * TBLNT + it) * TBLNU);
+      const size_t nu = (size_t) MAX(tbl->nu[id][ig][ip][it], 0);
+      memcpy(TBL_U(tbl, id, ig, ip, it), su + s, nu * sizeof(float));
+      memcpy(TBL_EPS(tbl, id, ig, ip, it), seps + s, nu * sizeof(float));
+    }
+
+  return n;
+}
+
+/*****************************************************************************/
+
+void init_tbl_group(
+  const ctl_t *ctl,
+  tbl_t *tbl) {
+
+  /* Loop over emitters... */
+  for (int ig = 0; ig < ctl->ng; ig++) {
+
+    /* Find first channel with the same pressure and temperature grids... */
+    int ngrp = 0;
+    for (int id = 0; id < ctl->nd; id++) {
+      tbl->ref[id][ig] = id;
+      for (int id2 = 0; id2 < id; id2++) {
+	if (tbl->ref[id2][ig] != id2 || tbl->np[id2][ig] != tbl->np[id][ig])
+	  continue;
+	int same = 1;
+	for (int ip = 0; ip < tbl->np[id][ig] && same; ip++) {
+	  if (tbl->p[id2][ig][ip] != tbl->p[id][ig][ip]
+	      || tbl->nt[id2][ig][ip] != tbl->nt[id][ig][ip])
+	    same = 0;
+	  for (int it = 0; it < tbl->nt[id][ig][ip] && same; it++)
+	    if (tbl->t[id2][ig][ip][it] != tbl->t[id][ig][ip][it])
+	      same = 0;
+	}
+	if (same) {
+	  tbl->ref[id][ig] = id2;
+	  break;
+	}
+      }
+      if (tbl->ref[id][ig] == id)
+	ngrp++;
+    }
+
+    /* Write info... */
+    LOG(2, "Emitter %s: %d channel groups with identical p/T grids",
+	ctl->emitter[ig], ngrp);
+  }
+}
+
+/*****************************************************************************/
+
+void init_tbl_guide(
+  const ctl_t *ctl,
+  tbl_t *tbl) {
+
+  /* Loop over table blocks... */
+  for (int id = 0; id < ctl->nd; id++)
+    for (int ig = 0; ig < ctl->ng; ig++) {
+
+      /* Allocate... */
+      if (tbl->ntab[id][ig] <= 0)
+	continue;
+      ALLOC(tbl->ugd[id][ig], unsigned short,
+	    tbl->ntab[id][ig] * TBLNB);
+      ALLOC(tbl->epsgd[id][ig], unsigned short,
+	    tbl->ntab[id][ig] * TBLNB);
+      ALLOC(tbl->ugds[id][ig], double,
+	    tbl->ntab[id][ig]);
+      ALLOC(tbl->epsgds[id][ig], double,
+	    tbl->ntab[id][ig]);
+
+      /* Loop over tables... */
+      for (int ip = 0; ip < tbl->np[id][ig]; ip++)
+	for (int it = 0; it < tbl->nt[id][ig][ip]; it++) {
+
+	  /* Check size of table... */
+	  const int nu = tbl->nu[id][ig][ip][it];
+	  if (nu < 2)
+	    continue;
+	  const int k = tbl->itab[id][ig][ip][it];
+
+	  /* Set guide tables of quantised tables (regular bins)... */
+	  if (tbl->quant) {
+	    const unsigned short *uq = TBL_UQ(tbl, id, ig, ip, it);
+	    const unsigned short *epsq = TBL_EPSQ(tbl, id, ig, ip, it);
+	    tbl->ugds[id][ig][k] = tbl->epsgds[id][ig][k] =
+	      (double) TBLNB / TBLQMAX;
+	    for (int ib = 0, iu = 0, ieps = 0; ib < TBLNB; ib++) {
+	      const double x = ib * (double) TBLQMAX / TBLNB;
+	      while (iu < nu - 2 && uq[iu + 1] <= x)
+		iu++;
+	      while (ieps < nu - 2 && epsq[ieps + 1] <= x)
+		ieps++;
+	      tbl->ugd[id][ig][k * TBLNB + ib] = (unsigned short) iu;
+	      tbl->epsgd[id][ig][k * TBLNB + ib] = (unsigned short) ieps;
+	    }
+	    continue;
+	  }
+
+	  const float *u = TBL_U(tbl, id, ig, ip, it);
+	  const float *eps = TBL_EPS(tbl, id, ig, ip, it);
+
+	  /* Get bin scaling factors... */
+	  const double us = (u[0] > 0 && u[nu - 1] > u[0]
+			     ? TBLNB / log(u[nu - 1] / u[0]) : 0);
+	  const double epss = (eps[nu - 1] > eps[0]
+			       ? TBLNB / (eps[nu - 1] - eps[0]) : 0);
+	  tbl->ugds[id][ig][k] = us;
+	  tbl->epsgds[id][ig][k] = epss;
+
+	  /* Set guide tables... */
+	  for (int ib = 0; ib < TBLNB; ib++) {
+	    const double ue = (us > 0 ? u[0] * exp(ib / us) : u[0]);
+	    const double epse = (epss > 0 ? eps[0] + ib / epss : eps[0]);
+	    tbl->ugd[id][ig][k * TBLNB + ib] =
+	      (unsigned short) locate_tbl(u, nu, ue);
+	    tbl->epsgd[id][ig][k * TBLNB + ib] =
+	      (unsigned short) locate_tbl(eps, nu, epse);
+	  }
+	}
+    }
+}
+
+/*****************************************************************************/
+
+void init_tbl_quant(
+  const ctl_t *ctl,
+  tbl_t *tbl) {
+
+  /* Check for memory-mapped tables... */
+  if (ctl->tblfmt == 4) {
+    WARN("Memory-mapped tables are not quantised!");
+    return;
+  }
+
+  /* Loop over table blocks... */
+  size_t mem = 0;
+  for (int id = 0; id < ctl->nd; id++)
+    for (int ig = 0; ig < ctl->ng; ig++) {
+
+      /* Check for empty block... */
+      if (!tbl->u[id][ig] || tbl->ntab[id][ig] <= 0)
+	continue;
+
+      /* Allocate... */
+      const int n = init_tbl_block(tbl, id, ig, NULL, NULL);
+      ALLOC(tbl->uq[id][ig], unsigned short,
+	    n);
+      ALLOC(tbl->epsq[id][ig], unsigned short,
+	    n);
+      ALLOC(tbl->uqs[id][ig], double,
+	    2 * tbl->ntab[id][ig]);
+      ALLOC(tbl->epsqs[id][ig], double,
+	    2 * tbl->ntab[id][ig]);
+      mem += (size_t) n * 2 * sizeof(unsigned short);
+
+      /* Loop over tables... */
+      for (int ip = 0; ip < tbl->np[id][ig]; ip++)
+	for (int it = 0; it < tbl->nt[id][ig][ip]; it++) {
+
+	  /* Check size of table... */
+	  const int nu = tbl->nu[id][ig][ip][it];
+	  if (nu < 1)
+	    continue;
+	  const float *u = TBL_U(tbl, id, ig, ip, it);
+	  const float *eps = TBL_EPS(tbl, id, ig, ip, it);
+	  unsigned short *uq = TBL_UQ(tbl, id, ig, ip, it);
+	  unsigned short *epsq = TBL_EPSQ(tbl, id, ig, ip, it);
+	  double *us = tbl->uqs[id][ig] + 2 * tbl->itab[id][ig][ip][it];
+	  double *es = tbl->epsqs[id][ig] + 2 * tbl->itab[id][ig][ip][it];
+
+	  /* Transform data (log and logit scale)... */
+	  double lu[TBLNU], leps[TBLNU];
+	  for (int iu = 0; iu < nu; iu++) {
+	    const double e = MIN(MAX(eps[iu], 1e-30), 1.0 - 1e-7);
+	    lu[iu] = log(MAX(u[iu], 1e-30));
+	    leps[iu] = log(e / (1.0 - e));
+	  }
+
+	  /* Get offsets and scaling factors... */
+	  us[0] = lu[0];
+	  us[1] = (lu[nu - 1] > lu[0] ? (lu[nu - 1] - lu[0]) / TBLQMAX : 1);
+	  es[0] = leps[0];
+	  es[1] = (leps[nu - 1] > leps[0] ? (leps[nu - 1] - leps[0]) / TBLQMAX
+		   : 1);
+
+	  /* Quantise data (strictly increasing)... */
+	  int qu[TBLNU], qeps[TBLNU];
+	  for (int iu = 0; iu < nu; iu++) {
+	    qu[iu] = (int) lround((lu[iu] - us[0]) / us[1]);
+	    qeps[iu] = (int) lround((leps[iu] - es[0]) / es[1]);
+	    if (iu > 0) {
+	      qu[iu] = MAX(qu[iu], qu[iu - 1] + 1);
+	      qeps[iu] = MAX(qeps[iu], qeps[iu - 1] + 1);
+	    }
+	  }
+	  for (int iu = nu - 1; iu >= 0; iu--) {
+	    qu[iu] = MIN(qu[iu], iu < nu - 1 ? qu[iu + 1] - 1 : TBLQMAX);
+	    qeps[iu] = MIN(qeps[iu], iu < nu - 1 ? qeps[iu + 1] - 1 : TBLQMAX);
+	  }
+	  for (int iu = 0; iu < nu; iu++) {
+	    uq[iu] = (unsigned short) qu[iu];
+	    epsq[iu] = (unsigned short) qeps[iu];
+	  }
+	}
+
+      /* Free float tables... */
+      free(tbl->u[id][ig]);
+      free(tbl->eps[id][ig]);
+      tbl->u[id][ig] = tbl->eps[id][ig] = NULL;
+    }
+
+  /* Set flag... */
+  tbl->quant = 1;
+
+  /* Write info... */
+  LOG(2, "Quantised emissivity tables: %g MByte",
+      (double) mem / 1024. / 1024.);
+}
+
+/*****************************************************************************/
+
+void intpol_atm(
+  const ctl_t *ctl,
+  const atm_t *atm,
+  const double z,
+  double *p,
+  double *t,
+  double *q,
+  double *k) {
+
+  /* Get array index... */
+  const int ip = locate_irr(atm->z, atm->np, z);
+
+  /* Interpolate... */
+  *p = LOGY(atm->z[ip], atm->p[ip], atm->z[ip + 1], atm->p[ip + 1], z);
+  *t = LIN(atm->z[ip], atm->t[ip], atm->z[ip + 1], atm->t[ip + 1], z);
+  for (int ig = 0; ig < ctl->ng; ig++)
+    q[ig] =
+      LIN(atm->z[ip], atm->q[ig][ip], atm->z[ip + 1], atm->q[ig][ip + 1], z);
+  for (int iw = 0; iw < ctl->nw; iw++)
+    k[iw] =
+      LIN(atm->z[ip], atm->k[iw][ip], atm->z[ip + 1], atm->k[iw][ip + 1], z);
+}
+
+/*****************************************************************************/
+
+void intpol_tbl_cga(
+  const ctl_t *ctl,
+  const tbl_t *tbl,
   const los_t *los,
   const int ip,
   double tau_path[ND][NG],
   double tau_seg[ND]) {
 
-  double eps;
+  double eps, p[NG], t[NG];
+
+  int jp[ND][NG], jt0[ND][NG], jt1[ND][NG];
+
+  /* Determine pressure and temperature indices... */
+  for (int ig = 0; ig < ctl->ng; ig++) {
+    p[ig] = los->cgp[ip][ig];
+    t[ig] = los->cgt[ip][ig];
+  }
+  intpol_tbl_idx(ctl, tbl, p, t, jp, jt0, jt1);
 
   /* Loop over channels... */
   for (int id = 0; id < ctl->nd; id++) {
@@ -4078,14 +4667,10 @@ void intpol_tbl_cga(
       /* Interpolate... */
       else {
 
-	/* Determine pressure and temperature indices... */
-	const int ipr =
-	  locate_irr(tbl->p[id][ig], tbl->np[id][ig], los->cgp[ip][ig]);
-	const int it0 = locate_reg(tbl->t[id][ig][ipr], tbl->nt[id][ig][ipr],
-				   los->cgt[ip][ig]);
-	const int it1 =
-	  locate_reg(tbl->t[id][ig][ipr + 1], tbl->nt[id][ig][ipr + 1],
-		     los->cgt[ip][ig]);
+	/* Get pressure and temperature indices... */
+	const int ipr = jp[id][ig];
+	const int it0 = jt0[id][ig];
+	const int it1 = jt1[id][ig];
 
 	/* Check size of table (temperature and column density)... */
 	if (tbl->nt[id][ig][ipr] < 2 || tbl->nt[id][ig][ipr + 1] < 2
@@ -4145,7 +4730,16 @@ void intpol_tbl_ega(
   double tau_path[ND][NG],
   double tau_seg[ND]) {
 
-  double eps, u;
+  double eps, p[NG], t[NG], u;
+
+  int jp[ND][NG], jt0[ND][NG], jt1[ND][NG];
+
+  /* Determine pressure and temperature indices... */
+  for (int ig = 0; ig < ctl->ng; ig++) {
+    p[ig] = los->p[ip];
+    t[ig] = los->t[ip];
+  }
+  intpol_tbl_idx(ctl, tbl, p, t, jp, jt0, jt1);
 
   /* Loop over channels... */
   for (int id = 0; id < ctl->nd; id++) {
@@ -4167,14 +4761,10 @@ void intpol_tbl_ega(
       /* Interpolate... */
       else {
 
-	/* Determine pressure and temperature indices... */
-	const int ipr =
-	  locate_irr(tbl->p[id][ig], tbl->np[id][ig], los->p[ip]);
-	const int it0 =
-	  locate_reg(tbl->t[id][ig][ipr], tbl->nt[id][ig][ipr], los->t[ip]);
-	const int it1 =
-	  locate_reg(tbl->t[id][ig][ipr + 1], tbl->nt[id][ig][ipr + 1],
-		     los->t[ip]);
+	/* Get pressure and temperature indices... */
+	const int ipr = jp[id][ig];
+	const int it0 = jt0[id][ig];
+	const int it1 = jt1[id][ig];
 
 	/* Check size of table (temperature and column density)... */
 	if (tbl->nt[id][ig][ipr] < 2 || tbl->nt[id][ig][ipr + 1] < 2
@@ -4241,9 +4831,15 @@ inline double intpol_tbl_eps(
   const int it,
   const double u) {
 
+  /* Quantised tables... */
+  if (tbl->quant)
+    return intpol_tbl_eps_q(tbl, ig, id, ip, it, u);
+
   const int nu = tbl->nu[id][ig][ip][it];
-  const float *u_arr = tbl->u[id][ig][ip][it];
-  const float *eps_arr = tbl->eps[id][ig][ip][it];
+  const int k = tbl->itab[id][ig][ip][it];
+
+  const float *u_arr = TBL_U(tbl, id, ig, ip, it);
+  const float *eps_arr = TBL_EPS(tbl, id, ig, ip, it);
 
   const double u_min = u_arr[0];
   const double u_max = u_arr[nu - 1];
@@ -4259,12 +4855,305 @@ inline double intpol_tbl_eps(
   }
 
   /* Interpolation... */
-  const int idx = locate_tbl(u_arr, nu, u);
+  const int ib = (int) MIN(log(u / u_min) * tbl->ugds[id][ig][k], TBLNB - 1);
+  const int idx =
+    locate_tbl_guide(u_arr, nu, u, tbl->ugd[id][ig] + k * TBLNB, ib);
   return LIN(u_arr[idx], eps_arr[idx], u_arr[idx + 1], eps_arr[idx + 1], u);
 }
 
 /*****************************************************************************/
 
+double intpol_tbl_eps_q(
+  const tbl_t *tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double u) {
+
+  const int nu = tbl->nu[id][ig][ip][it];
+  const int k = tbl->itab[id][ig][ip][it];
+  const unsigned short *uq = TBL_UQ(tbl, id, ig, ip, it);
+  const unsigned short *epsq = TBL_EPSQ(tbl, id, ig, ip, it);
+  const double *us = tbl->uqs[id][ig] + 2 * k;
+  const double *es = tbl->epsqs[id][ig] + 2 * k;
+
+  /* Lower boundary extrapolation... */
+  const double x = (u > 0 ? (log(u) - us[0]) / us[1] : -1);
+  if (x < 0)
+    return TBL_DEQ_EPS(es, epsq[0]) * u / TBL_DEQ_U(us, uq[0]);
+
+  /* Upper boundary extrapolation... */
+  if (x > uq[nu - 1]) {
+    const double a = log(1.0 - TBL_DEQ_EPS(es, epsq[nu - 1]))
+      / TBL_DEQ_U(us, uq[nu - 1]);
+    return 1.0 - exp(a * u);
+  }
+
+  /* Interpolation... */
+  const int ib = (int) MIN(x * tbl->ugds[id][ig][k], TBLNB - 1);
+  const int idx =
+    locate_tbl_guide_q(uq, nu, x, tbl->ugd[id][ig] + k * TBLNB, ib);
+  return LIN(TBL_DEQ_U(us, uq[idx]), TBL_DEQ_EPS(es, epsq[idx]),
+	     TBL_DEQ_U(us, uq[idx + 1]), TBL_DEQ_EPS(es, epsq[idx + 1]), u);
+}
+
+/*****************************************************************************/
+
+double intpol_tbl_eps_tl(
+  const tbl_t *tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double u,
+  double *deps) {
+
+  const int nu = tbl->nu[id][ig][ip][it];
+  const int k = tbl->itab[id][ig][ip][it];
+
+  double u0, u1, eps0, eps1;
+
+  /* Quantised tables... */
+  if (tbl->quant) {
+    const unsigned short *uq = TBL_UQ(tbl, id, ig, ip, it);
+    const unsigned short *epsq = TBL_EPSQ(tbl, id, ig, ip, it);
+    const double *us = tbl->uqs[id][ig] + 2 * k;
+    const double *es = tbl->epsqs[id][ig] + 2 * k;
+
+    /* Lower boundary extrapolation... */
+    const double x = (u > 0 ? (log(u) - us[0]) / us[1] : -1);
+    if (x < 0) {
+      *deps = TBL_DEQ_EPS(es, epsq[0]) / TBL_DEQ_U(us, uq[0]);
+      return *deps * u;
+    }
+
+    /* Upper boundary extrapolation... */
+    if (x > uq[nu - 1]) {
+      const double a = log(1.0 - TBL_DEQ_EPS(es, epsq[nu - 1]))
+	/ TBL_DEQ_U(us, uq[nu - 1]);
+      *deps = -a * exp(a * u);
+      return 1.0 - exp(a * u);
+    }
+
+    /* Get grid points... */
+    const int ib = (int) MIN(x * tbl->ugds[id][ig][k], TBLNB - 1);
+    const int idx =
+      locate_tbl_guide_q(uq, nu, x, tbl->ugd[id][ig] + k * TBLNB, ib);
+    u0 = TBL_DEQ_U(us, uq[idx]);
+    u1 = TBL_DEQ_U(us, uq[idx + 1]);
+    eps0 = TBL_DEQ_EPS(es, epsq[idx]);
+    eps1 = TBL_DEQ_EPS(es, epsq[idx + 1]);
+  }
+
+  /* Float tables... */
+  else {
+    const float *u_arr = TBL_U(tbl, id, ig, ip, it);
+    const float *eps_arr = TBL_EPS(tbl, id, ig, ip, it);
+
+    /* Lower boundary extrapolation... */
+    if (u < u_arr[0]) {
+      *deps = eps_arr[0] / (double) u_arr[0];
+      return eps_arr[0] * u / u_arr[0];
+    }
+
+    /* Upper boundary extrapolation... */
+    if (u > u_arr[nu - 1]) {
+      const double a = log(1.0 - eps_arr[nu - 1]) / u_arr[nu - 1];
+      *deps = -a * exp(a * u);
+      return 1.0 - exp(a * u);
+    }
+
+    /* Get grid points... */
+    const int ib =
+      (int) MIN(log(u / u_arr[0]) * tbl->ugds[id][ig][k], TBLNB - 1);
+    const int idx =
+      locate_tbl_guide(u_arr, nu, u, tbl->ugd[id][ig] + k * TBLNB, ib);
+    u0 = u_arr[idx];
+    u1 = u_arr[idx + 1];
+    eps0 = eps_arr[idx];
+    eps1 = eps_arr[idx + 1];
+  }
+
+  /* Interpolation... */
+  *deps = (eps1 - eps0) / (u1 - u0);
+  return LIN(u0, eps0, u1, eps1, u);
+}
+
+/*****************************************************************************/
+
+void intpol_tbl_idx(
+  const ctl_t *ctl,
+  const tbl_t *tbl,
+  const double *p,
+  const double *t,
+  int ipr[ND][NG],
+  int it0[ND][NG],
+  int it1[ND][NG]) {
+
+  /* Loop over emitters and channels... */
+  for (int ig = 0; ig < ctl->ng; ig++)
+    for (int id = 0; id < ctl->nd; id++) {
+
+      /* Check size of table (pressure)... */
+      if (tbl->np[id][ig] < 30)
+	continue;
+
+      /* Copy indices of channel with the same grids... */
+      const int ref = tbl->ref[id][ig];
+      if (ref < id) {
+	ipr[id][ig] = ipr[ref][ig];
+	it0[id][ig] = it0[ref][ig];
+	it1[id][ig] = it1[ref][ig];
+	continue;
+      }
+
+      /* Determine pressure and temperature indices... */
+      ipr[id][ig] = locate_irr(tbl->p[id][ig], tbl->np[id][ig], p[ig]);
+      it0[id][ig] = locate_reg(tbl->t[id][ig][ipr[id][ig]],
+			       tbl->nt[id][ig][ipr[id][ig]], t[ig]);
+      it1[id][ig] = locate_reg(tbl->t[id][ig][ipr[id][ig] + 1],
+			       tbl->nt[id][ig][ipr[id][ig] + 1], t[ig]);
+    }
+}
+
+/*****************************************************************************/
+
+void intpol_tbl_tl(
+  const ctl_t *ctl,
+  const tbl_t *tbl,
+  const los_t *los,
+  const int ip,
+  const int id,
+  double *tau_path,
+  double *tau_seg,
+  double *dtau) {
+
+  double de[4], dedtau[4], eps, e[4];
+
+  /* Initialize... */
+  *tau_seg = 1;
+
+  /* Loop over emitters.... */
+  for (int ig = 0; ig < ctl->ng; ig++) {
+
+    /* Get derivatives of transmittance of extended path... */
+    double *d = dtau + 4 * ig;
+    d[0] = d[1] = d[2] = 0;
+    d[3] = 1;
+
+    /* Check size of table (pressure) and column density... */
+    if (tbl->np[id][ig] < 30 || los->cgu[ip][ig] <= 0)
+      eps = 0;
+
+    /* Check transmittance... */
+    else if (tau_path[ig] < 1e-9) {
+      eps = 1;
+      d[3] = 0;
+    }
+
+    /* Interpolate... */
+    else {
+
+      /* Get pressure and temperature... */
+      const double p = (ctl->formod == 0 ? los->cgp[ip][ig] : los->p[ip]);
+      const double t = (ctl->formod == 0 ? los->cgt[ip][ig] : los->t[ip]);
+
+      /* Get pressure and temperature indices... */
+      const int ipr = locate_irr(tbl->p[id][ig], tbl->np[id][ig], p);
+      const int it0 = locate_reg(tbl->t[id][ig][ipr],
+				 tbl->nt[id][ig][ipr], t);
+      const int it1 = locate_reg(tbl->t[id][ig][ipr + 1],
+				 tbl->nt[id][ig][ipr + 1], t);
+      const int jp[4] = { ipr, ipr, ipr + 1, ipr + 1 };
+      const int jt[4] = { it0, it0 + 1, it1, it1 + 1 };
+
+      /* Check size of table (temperature and column density)... */
+      if (tbl->nt[id][ig][ipr] < 2 || tbl->nt[id][ig][ipr + 1] < 2
+	  || tbl->nu[id][ig][ipr][it0] < 2
+	  || tbl->nu[id][ig][ipr][it0 + 1] < 2
+	  || tbl->nu[id][ig][ipr + 1][it1] < 2
+	  || tbl->nu[id][ig][ipr + 1][it1 + 1] < 2)
+	eps = 0;
+
+      else {
+
+	/* Get emissivities of extended path and their derivatives... */
+	for (int i = 0; i < 4; i++)
+	  if (ctl->formod == 0) {
+	    e[i] = intpol_tbl_eps_tl(tbl, ig, id, jp[i], jt[i],
+				     los->cgu[ip][ig], &de[i]);
+	    dedtau[i] = 0;
+	  } else {
+	    double du;
+	    const double u = intpol_tbl_u_tl(tbl, ig, id, jp[i], jt[i],
+					     1 - tau_path[ig], &du);
+	    e[i] = intpol_tbl_eps_tl(tbl, ig, id, jp[i], jt[i],
+				     u + los->u[ip][ig], &de[i]);
+	    dedtau[i] = -de[i] * du;
+	  }
+
+	/* Interpolate with respect to temperature... */
+	const double t00 = tbl->t[id][ig][ipr][it0];
+	const double t01 = tbl->t[id][ig][ipr][it0 + 1];
+	const double t10 = tbl->t[id][ig][ipr + 1][it1];
+	const double t11 = tbl->t[id][ig][ipr + 1][it1 + 1];
+	const double e0 = LIN(t00, e[0], t01, e[1], t);
+	const double e1 = LIN(t10, e[2], t11, e[3], t);
+	const double w0 = (t - t00) / (t01 - t00);
+	const double w1 = (t - t10) / (t11 - t10);
+
+	/* Interpolate with respect to pressure... */
+	const double p0 = tbl->p[id][ig][ipr], p1 = tbl->p[id][ig][ipr + 1];
+	double eps00, wp, dedp;
+	if (ctl->formod == 0) {
+	  eps00 = LOGX(p0, e0, p1, e1, p);
+	  if (p / p0 > 0 && p1 / p0 > 0) {
+	    wp = log(p / p0) / log(p1 / p0);
+	    dedp = (e1 - e0) / (p * log(p1 / p0));
+	  } else {
+	    wp = (p - p0) / (p1 - p0);
+	    dedp = (e1 - e0) / (p1 - p0);
+	  }
+	} else {
+	  eps00 = LIN(p0, e0, p1, e1, p);
+	  wp = (p - p0) / (p1 - p0);
+	  dedp = (e1 - e0) / (p1 - p0);
+	}
+
+	/* Get derivatives (zero if emissivity is out of range)... */
+	const double w[4] = { (1 - wp) * (1 - w0), (1 - wp) * w0,
+	  wp * (1 - w1), wp * w1
+	};
+	d[3] = 0;
+	if (eps00 >= 0 && eps00 <= 1) {
+	  d[0] = -dedp;
+	  d[1] = -((1 - wp) * (e[1] - e[0]) / (t01 - t00)
+		   + wp * (e[3] - e[2]) / (t11 - t10));
+	  for (int i = 0; i < 4; i++) {
+	    d[2] -= w[i] * de[i];
+	    d[3] -= w[i] * dedtau[i];
+	  }
+	}
+
+	/* Check emissivity range... */
+	eps00 = MAX(MIN(eps00, 1), 0);
+
+	/* Determine segment emissivity... */
+	eps = 1 - (1 - eps00) / tau_path[ig];
+      }
+    }
+
+    /* Get transmittance of extended path... */
+    tau_path[ig] *= (1 - eps);
+
+    /* Get segment transmittance... */
+    *tau_seg *= (1 - eps);
+  }
+}
+
+/*****************************************************************************/
+
 inline double intpol_tbl_u(
   const tbl_t *tbl,
   const int ig,
@@ -4273,9 +5162,15 @@ inline double intpol_tbl_u(
   const int it,
   const double eps) {
 
+  /* Quantised tables... */
+  if (tbl->quant)
+    return intpol_tbl_u_q(tbl, ig, id, ip, it, eps);
+
   const int nu = tbl->nu[id][ig][ip][it];
-  const float *eps_arr = tbl->eps[id][ig][ip][it];
-  const float *u_arr = tbl->u[id][ig][ip][it];
+  const int k = tbl->itab[id][ig][ip][it];
+
+  const float *eps_arr = TBL_EPS(tbl, id, ig, ip, it);
+  const float *u_arr = TBL_U(tbl, id, ig, ip, it);
 
   const double eps_min = eps_arr[0];
   const double eps_max = eps_arr[nu - 1];
@@ -4291,12 +5186,136 @@ inline double intpol_tbl_u(
   }
 
   /* Interpolation... */
-  const int idx = locate_tbl(eps_arr, nu, eps);
+  const int ib =
+    (int) MIN((eps - eps_min) * tbl->epsgds[id][ig][k], TBLNB - 1);
+  const int idx =
+    locate_tbl_guide(eps_arr, nu, eps, tbl->epsgd[id][ig] + k * TBLNB, ib);
   return LIN(eps_arr[idx], u_arr[idx], eps_arr[idx + 1], u_arr[idx + 1], eps);
 }
 
 /*****************************************************************************/
 
+double intpol_tbl_u_q(
+  const tbl_t *tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double eps) {
+
+  const int nu = tbl->nu[id][ig][ip][it];
+  const int k = tbl->itab[id][ig][ip][it];
+  const unsigned short *epsq = TBL_EPSQ(tbl, id, ig, ip, it);
+  const unsigned short *uq = TBL_UQ(tbl, id, ig, ip, it);
+  const double *es = tbl->epsqs[id][ig] + 2 * k;
+  const double *us = tbl->uqs[id][ig] + 2 * k;
+
+  /* Lower boundary extrapolation... */
+  const double x = (eps <= 0 ? -1 : eps >= 1 ? TBLQMAX + 1
+		    : (log(eps / (1.0 - eps)) - es[0]) / es[1]);
+  if (x < 0)
+    return TBL_DEQ_U(us, uq[0]) * eps / TBL_DEQ_EPS(es, epsq[0]);
+
+  /* Upper boundary extrapolation... */
+  if (x > epsq[nu - 1]) {
+    const double a = log(1.0 - TBL_DEQ_EPS(es, epsq[nu - 1]))
+      / TBL_DEQ_U(us, uq[nu - 1]);
+    return log(1.0 - eps) / a;
+  }
+
+  /* Interpolation... */
+  const int ib = (int) MIN(x * tbl->epsgds[id][ig][k], TBLNB - 1);
+  const int idx =
+    locate_tbl_guide_q(epsq, nu, x, tbl->epsgd[id][ig] + k * TBLNB, ib);
+  return LIN(TBL_DEQ_EPS(es, epsq[idx]), TBL_DEQ_U(us, uq[idx]),
+	     TBL_DEQ_EPS(es, epsq[idx + 1]), TBL_DEQ_U(us, uq[idx + 1]), eps);
+}
+
+/*****************************************************************************/
+
+double intpol_tbl_u_tl(
+  const tbl_t *tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double eps,
+  double *du) {
+
+  const int nu = tbl->nu[id][ig][ip][it];
+  const int k = tbl->itab[id][ig][ip][it];
+
+  double u0, u1, eps0, eps1;
+
+  /* Quantised tables... */
+  if (tbl->quant) {
+    const unsigned short *epsq = TBL_EPSQ(tbl, id, ig, ip, it);
+    const unsigned short *uq = TBL_UQ(tbl, id, ig, ip, it);
+    const double *es = tbl->epsqs[id][ig] + 2 * k;
+    const double *us = tbl->uqs[id][ig] + 2 * k;
+
+    /* Lower boundary extrapolation... */
+    const double x = (eps <= 0 ? -1 : eps >= 1 ? TBLQMAX + 1
+		      : (log(eps / (1.0 - eps)) - es[0]) / es[1]);
+    if (x < 0) {
+      *du = TBL_DEQ_U(us, uq[0]) / TBL_DEQ_EPS(es, epsq[0]);
+      return *du * eps;
+    }
+
+    /* Upper boundary extrapolation... */
+    if (x > epsq[nu - 1]) {
+      const double a = log(1.0 - TBL_DEQ_EPS(es, epsq[nu - 1]))
+	/ TBL_DEQ_U(us, uq[nu - 1]);
+      *du = -1 / (a * (1.0 - eps));
+      return log(1.0 - eps) / a;
+    }
+
+    /* Get grid points... */
+    const int ib = (int) MIN(x * tbl->epsgds[id][ig][k], TBLNB - 1);
+    const int idx =
+      locate_tbl_guide_q(epsq, nu, x, tbl->epsgd[id][ig] + k * TBLNB, ib);
+    eps0 = TBL_DEQ_EPS(es, epsq[idx]);
+    eps1 = TBL_DEQ_EPS(es, epsq[idx + 1]);
+    u0 = TBL_DEQ_U(us, uq[idx]);
+    u1 = TBL_DEQ_U(us, uq[idx + 1]);
+  }
+
+  /* Float tables... */
+  else {
+    const float *eps_arr = TBL_EPS(tbl, id, ig, ip, it);
+    const float *u_arr = TBL_U(tbl, id, ig, ip, it);
+
+    /* Lower boundary extrapolation... */
+    if (eps < eps_arr[0]) {
+      *du = u_arr[0] / (double) eps_arr[0];
+      return u_arr[0] * eps / eps_arr[0];
+    }
+
+    /* Upper boundary extrapolation... */
+    if (eps > eps_arr[nu - 1]) {
+      const double a = log(1.0 - eps_arr[nu - 1]) / u_arr[nu - 1];
+      *du = -1 / (a * (1.0 - eps));
+      return log(1.0 - eps) / a;
+    }
+
+    /* Get grid points... */
+    const int ib =
+      (int) MIN((eps - eps_arr[0]) * tbl->epsgds[id][ig][k], TBLNB - 1);
+    const int idx =
+      locate_tbl_guide(eps_arr, nu, eps, tbl->epsgd[id][ig] + k * TBLNB, ib);
+    eps0 = eps_arr[idx];
+    eps1 = eps_arr[idx + 1];
+    u0 = u_arr[idx];
+    u1 = u_arr[idx + 1];
+  }
+
+  /* Interpolation... */
+  *du = (u1 - u0) / (eps1 - eps0);
+  return LIN(eps0, u0, eps1, u1, eps);
+}
+
+/*****************************************************************************/
+
 void jsec2time(
   const double jsec,
   int *year,
@@ -4337,7 +5356,9 @@ void kernel(
   obs_t *obs,
   gsl_matrix *k) {
 
-  int *iqa;
+  geo_t *geo = NULL;
+
+  int *done, *ipa, *iqa;
 
   /* Get sizes... */
   const size_t m = k->size1;
@@ -4346,6 +5367,10 @@ void kernel(
   /* Allocate... */
   gsl_vector *x0 = gsl_vector_alloc(n);
   gsl_vector *yy0 = gsl_vector_alloc(m);
+  ALLOC(done, int,
+	N);
+  ALLOC(ipa, int,
+	N);
   ALLOC(iqa, int,
 	N);
 
@@ -4353,78 +5378,447 @@ void kernel(
   formod(ctl, tbl, atm, obs);
 
   /* Compose vectors... */
-  atm2x(ctl, atm, x0, iqa, NULL);
+  atm2x(ctl, atm, x0, iqa, ipa);
   obs2y(ctl, obs, yy0, NULL, NULL);
 
   /* Initialize kernel matrix... */
   gsl_matrix_set_zero(k);
 
-  /* Loop over state vector elements... */
-#pragma omp parallel for default(none) shared(ctl,tbl,atm,obs,k,x0,yy0,n,m,iqa)
-  for (size_t j = 0; j < n; j++) {
+  /* Compute analytic derivatives... */
+  kernel_analytic(ctl, tbl, atm, obs, iqa, ipa, k, done);
 
-    /* Allocate... */
-    atm_t *atm1;
-    obs_t *obs1;
-    ALLOC(atm1, atm_t, 1);
-    ALLOC(obs1, obs_t, 1);
+  /* Count remaining derivatives... */
+  size_t nfd = 0;
+  for (size_t j = 0; j < n; j++)
+    if (!done[j])
+      nfd++;
+
+  /* Save LOS geometry (does not depend on the state without refraction)... */
+  if ((ctl->formod == 0 || ctl->formod == 1) && !ctl->refrac && nfd > 0) {
+    los_t *los;
+    ALLOC(geo, geo_t, obs->nr);
+    ALLOC(los, los_t, 1);
+    for (int ir = 0; ir < obs->nr; ir++) {
+      raytrace(ctl, atm, obs, los, ir);
+      geo[ir].np = los->np;
+      geo[ir].ground = (los->sft > 0);
+      for (int ip = 0; ip < los->np; ip++) {
+	geo[ir].z[ip] = los->z[ip];
+	geo[ir].lon[ip] = los->lon[ip];
+	geo[ir].lat[ip] = los->lat[ip];
+	geo[ir].ds[ip] = los->ds[ip];
+      }
+    }
+    free(los);
+  }
+
+  /* Compute remaining derivatives by finite differences... */
+#pragma omp parallel default(none) shared(ctl,tbl,atm,obs,k,x0,yy0,n,m,iqa,done,geo)
+  {
+    static atm_t *atm1 = NULL;
+    static obs_t *obs1 = NULL;
+#pragma omp threadprivate(atm1,obs1)
+
+    /* Allocate (once per thread)... */
+    if (atm1 == NULL)
+      ALLOC(atm1, atm_t, 1);
+    if (obs1 == NULL)
+      ALLOC(obs1, obs_t, 1);
     gsl_vector *x1 = gsl_vector_alloc(n);
     gsl_vector *yy1 = gsl_vector_alloc(m);
 
-    /* Set perturbation size... */
-    double h;
-    if (iqa[j] == IDXP)
-      h = MAX(fabs(0.01 * gsl_vector_get(x0, j)), 1e-7);
-    else if (iqa[j] == IDXT)
-      h = 1.0;
-    else if (iqa[j] >= IDXQ(0) && iqa[j] < IDXQ(ctl->ng))
-      h = MAX(fabs(0.01 * gsl_vector_get(x0, j)), 1e-15);
-    else if (iqa[j] >= IDXK(0) && iqa[j] < IDXK(ctl->nw))
-      h = 1e-4;
-    else if (iqa[j] == IDXCLZ || iqa[j] == IDXCLDZ)
-      h = 1.0;
-    else if (iqa[j] >= IDXCLK(0) && iqa[j] < IDXCLK(ctl->ncl))
-      h = 1e-4;
-    else if (iqa[j] == IDXSFT)
-      h = 1.0;
-    else if (iqa[j] >= IDXSFEPS(0) && iqa[j] < IDXSFEPS(ctl->nsf))
-      h = 1e-2;
-    else
-      ERRMSG("Cannot set perturbation size!");
+    /* Loop over state vector elements... */
+#pragma omp for
+    for (size_t j = 0; j < n; j++) {
+
+      /* Skip analytic derivatives... */
+      if (done[j])
+	continue;
+
+      /* Set perturbation size... */
+      double h;
+      if (iqa[j] == IDXP)
+	h = MAX(fabs(0.01 * gsl_vector_get(x0, j)), 1e-7);
+      else if (iqa[j] == IDXT)
+	h = 1.0;
+      else if (iqa[j] >= IDXQ(0) && iqa[j] < IDXQ(ctl->ng))
+	h = MAX(fabs(0.01 * gsl_vector_get(x0, j)), 1e-15);
+      else if (iqa[j] >= IDXK(0) && iqa[j] < IDXK(ctl->nw))
+	h = 1e-4;
+      else if (iqa[j] == IDXCLZ || iqa[j] == IDXCLDZ)
+	h = 1.0;
+      else if (iqa[j] >= IDXCLK(0) && iqa[j] < IDXCLK(ctl->ncl))
+	h = 1e-4;
+      else if (iqa[j] == IDXSFT)
+	h = 1.0;
+      else if (iqa[j] >= IDXSFEPS(0) && iqa[j] < IDXSFEPS(ctl->nsf))
+	h = 1e-2;
+      else
+	ERRMSG("Cannot set perturbation size!");
 
-    /* Disturb state vector element... */
-    gsl_vector_memcpy(x1, x0);
-    gsl_vector_set(x1, j, gsl_vector_get(x1, j) + h);
-    copy_atm(ctl, atm1, atm, 0);
-    copy_obs(ctl, obs1, obs, 0);
-    x2atm(ctl, x1, atm1);
+      /* Disturb state vector element... */
+      gsl_vector_memcpy(x1, x0);
+      gsl_vector_set(x1, j, gsl_vector_get(x1, j) + h);
+      copy_atm(ctl, atm1, atm, 0);
+      copy_obs(ctl, obs1, obs, 0);
+      x2atm(ctl, x1, atm1);
 
-    /* Compute radiance for disturbed atmospheric data... */
-    formod(ctl, tbl, atm1, obs1);
+      /* Compute radiance for disturbed atmospheric data... */
+      formod_geo(ctl, tbl, atm1, obs1, geo);
 
-    /* Compose measurement vector for disturbed radiance data... */
-    obs2y(ctl, obs1, yy1, NULL, NULL);
+      /* Compose measurement vector for disturbed radiance data... */
+      obs2y(ctl, obs1, yy1, NULL, NULL);
 
-    /* Compute derivatives... */
-    for (size_t i = 0; i < m; i++)
-      gsl_matrix_set(k, i, j,
-		     (gsl_vector_get(yy1, i) - gsl_vector_get(yy0, i)) / h);
+      /* Compute derivatives... */
+      for (size_t i = 0; i < m; i++)
+	gsl_matrix_set(k, i, j,
+		       (gsl_vector_get(yy1, i) - gsl_vector_get(yy0, i)) / h);
+    }
 
     /* Free... */
     gsl_vector_free(x1);
     gsl_vector_free(yy1);
-    free(atm1);
-    free(obs1);
   }
 
   /* Free... */
   gsl_vector_free(x0);
   gsl_vector_free(yy0);
+  free(geo);
+  free(done);
+  free(ipa);
   free(iqa);
 }
 
 /*****************************************************************************/
 
+void kernel_analytic(
+  const ctl_t *ctl,
+  const tbl_t *tbl,
+  const atm_t *atm,
+  obs_t *obs,
+  const int *iqa,
+  const int *ipa,
+  gsl_matrix *k,
+  int *done) {
+
+  double *hyd = NULL;
+
+  int *row;
+
+  /* Check forward model setup... */
+  if ((ctl->formod != 0 && ctl->formod != 1) || ctl->fov[0] != '-')
+    return;
+
+  /* Check reflectivity (see formod_pencil)... */
+  if (ctl->sftype >= 2 && ctl->nsf > 0)
+    for (int id = 0; id < ctl->nd; id++) {
+      const int isf = locate_irr(ctl->sfnu, ctl->nsf, ctl->nu[id]);
+      if (LIN(ctl->sfnu[isf], atm->sfeps[isf], ctl->sfnu[isf + 1],
+	      atm->sfeps[isf + 1], ctl->nu[id]) < 1)
+	return;
+    }
+
+  /* Get sizes... */
+  const size_t m = k->size1;
+  const size_t n = k->size2;
+
+  /* Flag state vector elements (profiles only without refraction)... */
+  int nana = 0;
+  for (size_t j = 0; j < n; j++)
+    if ((!ctl->refrac && (iqa[j] == IDXP || iqa[j] == IDXT
+			  || (iqa[j] >= IDXQ(0) && iqa[j] < IDXQ(ctl->ng))))
+	|| (iqa[j] >= IDXK(0) && iqa[j] < IDXK(ctl->nw))
+	|| iqa[j] == IDXSFT
+	|| (iqa[j] >= IDXSFEPS(0) && iqa[j] < IDXSFEPS(ctl->nsf))) {
+      done[j] = 1;
+      nana++;
+    }
+  if (nana == 0)
+    return;
+
+  /* Get pressure changes due to hydrostatic equilibrium
+     (by finite differences)... */
+  if (ctl->hydz >= 0 && !ctl->refrac) {
+    atm_t *atm1;
+    ALLOC(atm1, atm_t, 1);
+    ALLOC(hyd, double,
+	  n * NP);
+    for (size_t j = 0; j < n; j++) {
+      double *x, h;
+      copy_atm(ctl, atm1, atm, 0);
+      if (iqa[j] == IDXP) {
+	x = &atm1->p[ipa[j]];
+	h = MAX(fabs(1e-3 * *x), 1e-10);
+      } else if (iqa[j] == IDXT) {
+	x = &atm1->t[ipa[j]];
+	h = 1e-2;
+      } else if (iqa[j] >= IDXQ(0) && iqa[j] < IDXQ(ctl->ng)) {
+	x = &atm1->q[iqa[j] - IDXQ(0)][ipa[j]];
+	h = MAX(fabs(1e-3 * *x), 1e-15);
+      } else
+	continue;
+      *x += h;
+      hydrostatic(ctl, atm1);
+      for (int ip = 0; ip < atm->np; ip++)
+	hyd[j * NP + (size_t) ip] = (atm1->p[ip] - atm->p[ip]) / h;
+    }
+    free(atm1);
+  }
+
+  /* Get rows of measurement vector... */
+  ALLOC(row, int,
+	ND * NR);
+  for (int i = 0; i < ND * NR; i++)
+    row[i] = -1;
+  int nrow = 0;
+  for (int ir = 0; ir < obs->nr; ir++)
+    for (int id = 0; id < ctl->nd; id++)
+      if (isfinite(obs->rad[id][ir]))
+	row[id * NR + ir] = nrow++;
+  if ((size_t) nrow != m)
+    ERRMSG("Size of measurement vector mismatch!");
+
+  /* Loop over rays... */
+#pragma omp parallel for default(none) shared(ctl,tbl,atm,obs,iqa,ipa,k,done,row,hyd,n)
+  for (int ir = 0; ir < obs->nr; ir++) {
+
+    static los_t *los = NULL;
+    static double *dbeta = NULL, *dtau = NULL, *seg = NULL, *tp = NULL;
+#pragma omp threadprivate(los,dbeta,dtau,seg,tp)
+
+    double dk[NP], dp[NP], dq[NG][NP], dt[NP];
+
+    /* Allocate (once per thread)... */
+    if (los == NULL) {
+      ALLOC(los, los_t, 1);
+      ALLOC(dbeta, double,
+	    NLOS * 5);
+      ALLOC(dtau, double,
+	    NLOS * NG * 4);
+      ALLOC(seg, double,
+	    NLOS * 5);
+      ALLOC(tp, double,
+	    (NLOS + 1) * NG);
+    }
+
+    /* Set segment data (source function, its temperature derivative,
+       emissivity, gas transmittance, path transmittance)... */
+    double *src = seg, *dsrc = seg + NLOS, *eps = seg + 2 * NLOS,
+      *tg = seg + 3 * NLOS, *tr = seg + 4 * NLOS;
+
+    /* Raytracing... */
+    raytrace(ctl, atm, obs, los, ir);
+
+    /* Get surface source function and its temperature derivative... */
+    const int sf = (ctl->sftype >= 1 && los->sft > 0);
+    double src_sf[ND], dsrc_sf[ND];
+    if (sf) {
+      formod_srcfunc(ctl, tbl, los->sft, src_sf);
+      const int it = locate_reg(tbl->st, TBLNS, los->sft);
+      for (int id = 0; id < ctl->nd; id++)
+	dsrc_sf[id] = (tbl->sr[it + 1][id] - tbl->sr[it][id])
+	  / (tbl->st[it + 1] - tbl->st[it]);
+    }
+
+    /* Loop over channels... */
+    for (int id = 0; id < ctl->nd; id++) {
+
+      /* Skip masked measurements... */
+      const int i = row[id * NR + ir];
+      if (i < 0)
+	continue;
+
+      /* Initialize... */
+      double rad = 0, tau = 1, tau_path[NG];
+      for (int ig = 0; ig < ctl->ng; ig++)
+	tau_path[ig] = 1;
+
+      /* Get segment emissivities, radiance, and local derivatives... */
+      for (int ip = 0; ip < los->np; ip++) {
+	for (int ig = 0; ig < ctl->ng; ig++)
+	  tp[ip * NG + ig] = tau_path[ig];
+	intpol_tbl_tl(ctl, tbl, los, ip, id, tau_path, &tg[ip],
+		      &dtau[ip * NG * 4]);
+	double beta;
+	formod_continua_tl(ctl, tbl, los, ip, id, &beta, &dbeta[ip * 5]);
+	const int it = locate_reg(tbl->st, TBLNS, los->t[ip]);
+	src[ip] = LIN(tbl->st[it], tbl->sr[it][id],
+		      tbl->st[it + 1], tbl->sr[it + 1][id], los->t[ip]);
+	dsrc[ip] = (tbl->sr[it + 1][id] - tbl->sr[it][id])
+	  / (tbl->st[it + 1] - tbl->st[it]);
+	eps[ip] = (tg[ip] > 0 ? 1 - tg[ip] * exp(-beta * los->ds[ip]) : 0);
+	tr[ip] = tau;
+	rad += src[ip] * eps[ip] * tau;
+	tau *= (1 - eps[ip]);
+      }
+      for (int ig = 0; ig < ctl->ng; ig++)
+	tp[los->np * NG + ig] = tau_path[ig];
+      double after = (sf ? los->sfeps[id] * src_sf[id] * tau : 0);
+      rad += after;
+
+      /* Get derivative of brightness temperature... */
+      double scl = 1;
+      if (ctl->write_bbt) {
+	const double a = C1 * POW3(ctl->nu[id]);
+	const double bt = BRIGHT(rad, ctl->nu[id]);
+	scl = POW2(bt) / (C2 * ctl->nu[id]) * a / (rad * (rad + a));
+      }
+
+      /* Initialize derivatives on atmospheric grid... */
+      for (int ip = 0; ip < atm->np; ip++) {
+	dk[ip] = dp[ip] = dt[ip] = 0;
+	for (int ig = 0; ig < ctl->ng; ig++)
+	  dq[ig][ip] = 0;
+      }
+
+      /* Backward pass over LOS points... */
+      double lam[NG], sp[NG], st[NG], su[NG];
+      for (int ig = 0; ig < ctl->ng; ig++)
+	lam[ig] = sp[ig] = st[ig] = su[ig] = 0;
+      for (int ip = los->np - 1; ip >= 0; ip--) {
+
+	/* Surface temperature taken from the atmosphere... */
+	double gk = 0, gp = 0, gq = 0, gt = 0, gu[NG];
+	if (ip == los->np - 1 && sf && !(ctl->nsf > 0 && atm->sft > 0))
+	  gt = los->sfeps[id] * dsrc_sf[id] * tau;
+	for (int ig = 0; ig < ctl->ng; ig++)
+	  gu[ig] = 0;
+
+	/* Derivatives with respect to extinction and gas transmittance... */
+	double drdg = 0;
+	if (tg[ip] > 0) {
+	  const double *db = &dbeta[ip * 5];
+	  gk = los->ds[ip]
+	    * ((1 - eps[ip]) * src[ip] * tr[ip] - after);
+	  gt += gk * db[0];
+	  gp += gk * db[1];
+	  if (ctl->ig_co2 >= 0)
+	    gu[ctl->ig_co2] += gk * db[2];
+	  if (ctl->ig_h2o >= 0) {
+	    gu[ctl->ig_h2o] += gk * db[3];
+	    gq += gk * db[4];
+	  }
+	  drdg = (after - (1 - eps[ip]) * src[ip] * tr[ip]) / tg[ip];
+	}
+
+	/* Derivative with respect to source function... */
+	gt += eps[ip] * tr[ip] * dsrc[ip];
+
+	/* Chain rule for emitters... */
+	for (int ig = 0; ig < ctl->ng; ig++) {
+	  const double *d = &dtau[(ip * NG + ig) * 4];
+	  const double mu = lam[ig]
+	    + (tg[ip] > 0 ? drdg * tg[ip] / tp[(ip + 1) * NG + ig] : 0);
+	  lam[ig] = mu * d[3]
+	    - (tg[ip] > 0 ? drdg * tg[ip] / tp[ip * NG + ig] : 0);
+
+	  /* EGA (local pressure, temperature, column density)... */
+	  if (ctl->formod == 1) {
+	    gp += mu * d[0];
+	    gt += mu * d[1];
+	    gu[ig] += mu * d[2];
+	  }
+
+	  /* CGA (Curtis-Godson means of path up to this point)... */
+	  else {
+	    const double cgu = los->cgu[ip][ig];
+	    if (cgu != 0) {
+	      sp[ig] += mu * d[0] / cgu;
+	      st[ig] += mu * d[1] / cgu;
+	      su[ig] += mu * (d[2] - (d[0] * los->cgp[ip][ig]
+				      + d[1] * los->cgt[ip][ig]) / cgu);
+	    }
+	    gu[ig] += su[ig] + sp[ig] * los->p[ip] + st[ig] * los->t[ip];
+	    gp += los->u[ip][ig] * sp[ig];
+	    gt += los->u[ip][ig] * st[ig];
+	  }
+	}
+
+	/* Chain rule for column densities... */
+	double gv[NG];
+	for (int ig = 0; ig < ctl->ng; ig++) {
+	  gv[ig] = gu[ig] * 10 * los->p[ip] / (KB * los->t[ip]) * los->ds[ip];
+	  gp += gu[ig] * los->u[ip][ig] / los->p[ip];
+	  gt -= gu[ig] * los->u[ip][ig] / los->t[ip];
+	}
+	if (ctl->ig_h2o >= 0)
+	  gv[ctl->ig_h2o] += gq;
+
+	/* Chain rule for profile interpolation... */
+	const int ia = locate_irr(atm->z, atm->np, los->z[ip]);
+	const double w = (los->z[ip] - atm->z[ia])
+	  / (atm->z[ia + 1] - atm->z[ia]);
+	dk[ia] += (1 - w) * gk;
+	dk[ia + 1] += w * gk;
+	dt[ia] += (1 - w) * gt;
+	dt[ia + 1] += w * gt;
+	if (atm->p[ia + 1] / atm->p[ia] > 0) {
+	  dp[ia] += (1 - w) * los->p[ip] / atm->p[ia] * gp;
+	  dp[ia + 1] += w * los->p[ip] / atm->p[ia + 1] * gp;
+	} else {
+	  dp[ia] += (1 - w) * gp;
+	  dp[ia + 1] += w * gp;
+	}
+	for (int ig = 0; ig < ctl->ng; ig++) {
+	  dq[ig][ia] += (1 - w) * gv[ig];
+	  dq[ig][ia + 1] += w * gv[ig];
+	}
+
+	/* Add radiance contribution of this segment... */
+	after += src[ip] * eps[ip] * tr[ip];
+      }
+
+      /* Get weight of surface emissivity interpolation... */
+      int isf = 0;
+      double w = 0;
+      if (ctl->nsf > 0) {
+	isf = locate_irr(ctl->sfnu, ctl->nsf, ctl->nu[id]);
+	w = (ctl->nu[id] - ctl->sfnu[isf])
+	  / (ctl->sfnu[isf + 1] - ctl->sfnu[isf]);
+      }
+
+      /* Set kernel matrix... */
+      for (size_t j = 0; j < n; j++) {
+	if (!done[j])
+	  continue;
+	double d = 0;
+	if (iqa[j] == IDXP)
+	  d = (hyd == NULL ? dp[ipa[j]] : 0);
+	else if (iqa[j] == IDXT)
+	  d = dt[ipa[j]];
+	else if (iqa[j] >= IDXQ(0) && iqa[j] < IDXQ(ctl->ng))
+	  d = dq[iqa[j] - IDXQ(0)][ipa[j]];
+	else if (iqa[j] == IDXK(ctl->window[id]))
+	  d = dk[ipa[j]];
+	else if (iqa[j] == IDXSFT) {
+	  if (sf && ctl->nsf > 0 && atm->sft > 0)
+	    d = los->sfeps[id] * dsrc_sf[id] * tau;
+	} else if (iqa[j] == IDXSFEPS(isf)) {
+	  if (sf)
+	    d = (1 - w) * src_sf[id] * tau;
+	} else if (iqa[j] == IDXSFEPS(isf + 1)) {
+	  if (sf)
+	    d = w * src_sf[id] * tau;
+	}
+
+	/* Add pressure changes due to hydrostatic equilibrium... */
+	if (hyd != NULL && (iqa[j] == IDXP || iqa[j] == IDXT
+			    || (iqa[j] >= IDXQ(0) && iqa[j] < IDXQ(ctl->ng))))
+	  for (int ip = 0; ip < atm->np; ip++)
+	    d += dp[ip] * hyd[j * NP + (size_t) ip];
+
+	gsl_matrix_set(k, (size_t) i, j, scl * d);
+      }
+    }
+  }
+
+  /* Free... */
+  free(hyd);
+  free(row);
+}
+
+/*****************************************************************************/
+
 int locate_irr(
   const double *xx,
   const int n,
@@ -4496,6 +5890,48 @@ inline int locate_tbl(
 
 /*****************************************************************************/
 
+inline int locate_tbl_guide(
+  const float *xx,
+  const int n,
+  const double x,
+  const unsigned short *gd,
+  const int ib) {
+
+  /* Get start index from guide table... */
+  int i = gd[ib];
+
+  /* Step to interval... */
+  while (i < n - 2 && xx[i + 1] <= x)
+    i++;
+  while (i > 0 && xx[i] > x)
+    i--;
+
+  return i;
+}
+
+/*****************************************************************************/
+
+inline int locate_tbl_guide_q(
+  const unsigned short *xx,
+  const int n,
+  const double x,
+  const unsigned short *gd,
+  const int ib) {
+
+  /* Get start index from guide table... */
+  int i = gd[ib];
+
+  /* Step to interval... */
+  while (i < n - 2 && xx[i + 1] <= x)
+    i++;
+  while (i > 0 && xx[i] > x)
+    i--;
+
+  return i;
+}
+
+/*****************************************************************************/
+
 void matrix_invert(
   gsl_matrix *a) {
 
@@ -4608,7 +6044,24 @@ void optimal_estimation(
   atm_t *atm_i,
   double *chisq) {
 
-  static int ipa[N], iqa[N];
+  optimal_estimation_warm(ret, ctl, tbl, obs_meas, obs_i, atm_apr, atm_i,
+			  chisq, NULL);
+}
+
+/*****************************************************************************/
+
+void optimal_estimation_warm(
+  ret_t *ret,
+  ctl_t *ctl,
+  tbl_t *tbl,
+  obs_t *obs_meas,
+  obs_t *obs_i,
+  atm_t *atm_apr,
+  atm_t *atm_i,
+  double *chisq,
+  warm_t *warm) {
+
+  int *ipa, *iqa, conv = 0, warm_ok = 0;
 
   double disq = 0, lmpar = 0.001;
 
@@ -4616,12 +6069,22 @@ void optimal_estimation(
      Initialize...
      ------------------------------------------------------------ */
 
+  /* Allocate... */
+  ALLOC(ipa, int,
+	N);
+  ALLOC(iqa, int,
+	N);
+
   /* Get sizes... */
   const size_t m = obs2y(ctl, obs_meas, NULL, NULL, NULL);
   const size_t n = atm2x(ctl, atm_apr, NULL, iqa, ipa);
   if (m == 0 || n == 0) {
     WARN("Check problem definition (m = 0 or n = 0)!");
     *chisq = GSL_NAN;
+    if (warm != NULL)
+      warm->valid = 0;
+    free(ipa);
+    free(iqa);
     return;
   }
 
@@ -4673,11 +6136,56 @@ void optimal_estimation(
   /* Compute cost function... */
   *chisq = cost_function(dx, dy, s_a_inv, sig_eps_inv);
 
+  /* Try warm start from previous retrieval... */
+  if (warm != NULL && warm->valid && warm->x->size == n
+      && warm->k->size1 == m && warm->k->size2 == n) {
+
+    /* Allocate... */
+    atm_t *atm_w;
+    obs_t *obs_w;
+    ALLOC(atm_w, atm_t, 1);
+    ALLOC(obs_w, obs_t, 1);
+
+    /* Forward calculation for previous state... */
+    copy_atm(ctl, atm_w, atm_apr, 0);
+    copy_obs(ctl, obs_w, obs_meas, 0);
+    x2atm(ctl, warm->x, atm_w);
+    formod(ctl, tbl, atm_w, obs_w);
+    obs2y(ctl, obs_w, y_aux, NULL, NULL);
+
+    /* Compute cost function (use x_step and y_aux as dx and dy)... */
+    gsl_vector_memcpy(x_step, warm->x);
+    gsl_vector_sub(x_step, x_a);
+    for (size_t i = 0; i < m; i++)
+      gsl_vector_set(y_aux, i, gsl_vector_get(y_m, i)
+		     - gsl_vector_get(y_aux, i));
+    const double chisq_w =
+      cost_function(x_step, y_aux, s_a_inv, sig_eps_inv);
+    LOG(2, "warm start: chi^2/m= %g (a priori: %g)", chisq_w, *chisq);
+
+    /* Accept warm start if the cost function is lower... */
+    if (chisq_w < *chisq) {
+      copy_atm(ctl, atm_i, atm_w, 0);
+      copy_obs(ctl, obs_i, obs_w, 0);
+      gsl_vector_memcpy(x_i, warm->x);
+      gsl_vector_memcpy(dx, x_step);
+      gsl_vector_memcpy(dy, y_aux);
+      gsl_matrix_memcpy(k_i, warm->k);
+      *chisq = chisq_w;
+      warm_ok = 1;
+    }
+
+    /* Free... */
+    free(atm_w);
+    free(obs_w);
+  }
+
   /* Write info... */
   LOG(2, "it= %d / chi^2/m= %g", 0, *chisq);
 
   /* Compute initial kernel... */
-  kernel(ctl, tbl, atm_i, obs_i, k_i);
+  if (!warm_ok)
+    kernel(ctl, tbl, atm_i, obs_i, k_i);
 
   /* ------------------------------------------------------------
      Levenberg-Marquardt minimization...
@@ -4770,8 +6278,10 @@ void optimal_estimation(
     disq /= (double) n;
 
     /* Convergence test... */
-    if ((it == 1 || it % ret->kernel_recomp == 0) && disq < ret->conv_dmin)
+    if ((it == 1 || it % ret->kernel_recomp == 0) && disq < ret->conv_dmin) {
+      conv = 1;
       break;
+    }
   }
 
   /* ------------------------------------------------------------
@@ -4849,6 +6359,23 @@ void optimal_estimation(
      Finalize...
      ------------------------------------------------------------ */
 
+  /* Store warm-start data for next retrieval (converged results only)... */
+  if (warm != NULL && conv && gsl_finite(*chisq)) {
+    if (warm->x == NULL || warm->x->size != n) {
+      if (warm->x != NULL)
+	gsl_vector_free(warm->x);
+      warm->x = gsl_vector_alloc(n);
+    }
+    if (warm->k == NULL || warm->k->size1 != m || warm->k->size2 != n) {
+      if (warm->k != NULL)
+	gsl_matrix_free(warm->k);
+      warm->k = gsl_matrix_alloc(m, n);
+    }
+    gsl_vector_memcpy(warm->x, x_i);
+    gsl_matrix_memcpy(warm->k, k_i);
+    warm->valid = 1;
+  }
+
   gsl_matrix_free(a);
   gsl_matrix_free(cov);
   gsl_matrix_free(k_i);
@@ -4866,6 +6393,9 @@ void optimal_estimation(
   gsl_vector_free(y_aux);
   gsl_vector_free(y_i);
   gsl_vector_free(y_m);
+
+  free(ipa);
+  free(iqa);
 }
 
 /*****************************************************************************/
@@ -5078,6 +6608,16 @@ void raytrace(
     los->ds[ip] = 0.5 * (los->ds[ip - 1] + los->ds[ip]);
   los->ds[0] *= 0.5;
 
+  /* Compute column densities and Curtis-Godson means... */
+  raytrace_cgm(ctl, los);
+}
+
+/*****************************************************************************/
+
+void raytrace_cgm(
+  const ctl_t *ctl,
+  los_t *los) {
+
   /* Compute column density... */
   for (int ip = 0; ip < los->np; ip++)
     for (int ig = 0; ig < ctl->ng; ig++)
@@ -5106,6 +6646,75 @@ void raytrace(
 
 /*****************************************************************************/
 
+void raytrace_geo(
+  const ctl_t *ctl,
+  const atm_t *atm,
+  const geo_t *geo,
+  los_t *los) {
+
+  double k[NW], p, q[NG], t;
+
+  /* Initialize... */
+  los->np = geo->np;
+  los->sft = -999;
+
+  /* Loop over LOS points... */
+  for (int ip = 0; ip < los->np; ip++) {
+
+    /* Interpolate atmospheric data... */
+    intpol_atm(ctl, atm, geo->z[ip], &p, &t, q, k);
+
+    /* Save data... */
+    los->lon[ip] = geo->lon[ip];
+    los->lat[ip] = geo->lat[ip];
+    los->z[ip] = geo->z[ip];
+    los->p[ip] = p;
+    los->t[ip] = t;
+    for (int ig = 0; ig < ctl->ng; ig++)
+      los->q[ip][ig] = q[ig];
+    for (int id = 0; id < ctl->nd; id++)
+      los->k[ip][id] = k[ctl->window[id]];
+    los->ds[ip] = geo->ds[ip];
+
+    /* Add cloud extinction... */
+    if (ctl->ncl > 0 && atm->cldz > 0) {
+      const double aux =
+	exp(-0.5 * POW2((geo->z[ip] - atm->clz) / atm->cldz));
+      for (int id = 0; id < ctl->nd; id++) {
+	const int icl = locate_irr(ctl->clnu, ctl->ncl, ctl->nu[id]);
+	los->k[ip][id]
+	  += aux * LIN(ctl->clnu[icl], atm->clk[icl],
+		       ctl->clnu[icl + 1], atm->clk[icl + 1], ctl->nu[id]);
+      }
+    }
+  }
+
+  /* Set surface data... */
+  if (los->np > 0) {
+
+    /* Set surface temperature... */
+    if (geo->ground)
+      los->sft = (ctl->nsf > 0 && atm->sft > 0 ? atm->sft
+		  : los->t[los->np - 1]);
+
+    /* Set surface emissivity... */
+    for (int id = 0; id < ctl->nd; id++) {
+      los->sfeps[id] = 1.0;
+      if (ctl->nsf > 0) {
+	const int isf = locate_irr(ctl->sfnu, ctl->nsf, ctl->nu[id]);
+	los->sfeps[id] = LIN(ctl->sfnu[isf], atm->sfeps[isf],
+			     ctl->sfnu[isf + 1], atm->sfeps[isf + 1],
+			     ctl->nu[id]);
+      }
+    }
+  }
+
+  /* Compute column densities and Curtis-Godson means... */
+  raytrace_cgm(ctl, los);
+}
+
+/*****************************************************************************/
+
 void read_atm(
   const char *dirname,
   const char *filename,
@@ -5379,6 +6988,8 @@ void read_ctl(
   /* Emissivity look-up tables... */
   scan_ctl(argc, argv, "TBLBASE", -1, "-", ctl->tblbase);
   ctl->tblfmt = (int) scan_ctl(argc, argv, "TBLFMT", -1, "1", NULL);
+  ctl->tblquant = (int) scan_ctl(argc, argv, "TBLQUANT", -1, "0", NULL);
+  scan_ctl(argc, argv, "SRCCACHE", -1, "-", ctl->srccache);
 
   /* File formats... */
   ctl->atmfmt = (int) scan_ctl(argc, argv, "ATMFMT", -1, "1", NULL);
@@ -5884,52 +7495,172 @@ void read_shape(
 
 /*****************************************************************************/
 
+int read_srcfunc(
+  const char *filename,
+  const uint64_t hash,
+  double *sr) {
+
+  char magic[4];
+
+  double tmin, tmax;
+
+  uint64_t fhash;
+
+  int32_t ns;
+
+  /* Open file... */
+  FILE *in;
+  if (!(in = fopen(filename, "r")))
+    return -1;
+
+  /* Read and check header... */
+  if (fread(magic, sizeof(char), 4, in) != 4
+      || memcmp(magic, "SRC1", 4) != 0
+      || fread(&fhash, sizeof(uint64_t), 1, in) != 1 || fhash != hash
+      || fread(&ns, sizeof(int32_t), 1, in) != 1 || ns != TBLNS
+      || fread(&tmin, sizeof(double), 1, in) != 1 || tmin != TMIN
+      || fread(&tmax, sizeof(double), 1, in) != 1 || tmax != TMAX
+      || fread(sr, sizeof(double), TBLNS, in) != TBLNS) {
+    WARN("Invalid source function cache file: %s", filename);
+    fclose(in);
+    return -1;
+  }
+
+  /* Close file... */
+  fclose(in);
+
+  /* Write info... */
+  LOG(1, "Read source function: %s", filename);
+
+  return 0;
+}
+
+/*****************************************************************************/
+
 tbl_t *read_tbl(
   const ctl_t *ctl) {
 
+  tbl_gas_t gas[NG];
+
   /* Allocate... */
   tbl_t *tbl;
   ALLOC(tbl, tbl_t, 1);
 
-  /* Loop over trace gases and channels... */
-  for (int id = 0; id < ctl->nd; id++)
+  /* Open per-gas look-up tables once per gas... */
+  memset(gas, 0, sizeof(gas));
+  if (ctl->tblfmt == 3)
     for (int ig = 0; ig < ctl->ng; ig++) {
+      char filename[2 * LEN];
+      sprintf(filename, "%s_%s.tbl", ctl->tblbase, ctl->emitter[ig]);
+      LOG(1, "Read emissivity table: %s", filename);
+      if (read_tbl_gas_open(filename, &gas[ig]) != 0)
+	WARN("Missing emissivity table: %s", filename);
+    }
 
-      /* Initialize... */
-      tbl->np[id][ig] = -1;
+  /* Map memory-mapped look-up tables once per gas... */
+  if (ctl->tblfmt == 4)
+    for (int ig = 0; ig < ctl->ng; ig++) {
+      char filename[2 * LEN];
+      sprintf(filename, "%s_%s.map", ctl->tblbase, ctl->emitter[ig]);
+      LOG(1, "Map emissivity table: %s", filename);
+      if (read_tbl_map_open(filename, tbl, ig) != 0)
+	WARN("Missing emissivity table: %s", filename);
+    }
 
-      /* Read ASCII look-up tables... */
-      if (ctl->tblfmt == 1)
-	read_tbl_asc(ctl, tbl, id, ig);
+  /* Read tables of all channels in parallel... */
+#pragma omp parallel default(none) shared(ctl,tbl,gas) if(ctl->tblfmt != 4)
+  {
+    float *su, *seps;
 
-      /* Read binary look-up tables... */
-      else if (ctl->tblfmt == 2)
-	read_tbl_bin(ctl, tbl, id, ig);
+    /* Allocate staging buffers... */
+    ALLOC(su, float,
+	  TBLNP * TBLNT * TBLNU);
+    ALLOC(seps, float,
+	  TBLNP * TBLNT * TBLNU);
 
-      /* Read per-gas look-up tables... */
-      else if (ctl->tblfmt == 3)
-	read_tbl_gas(ctl, tbl, id, ig);
+    /* Loop over trace gases and channels... */
+#pragma omp for collapse(2) schedule(dynamic)
+    for (int id = 0; id < ctl->nd; id++)
+      for (int ig = 0; ig < ctl->ng; ig++) {
 
-      /* Error message... */
-      else
-	ERRMSG("Unknown look-up table format!");
+	/* Initialize... */
+	tbl->np[id][ig] = -1;
 
-      /* Write info... */
+	/* Map memory-mapped look-up tables... */
+	if (ctl->tblfmt == 4)
+	  read_tbl_map(ctl, tbl, id, ig);
+
+	/* Read look-up tables... */
+	else {
+
+	  /* Read into staging buffers... */
+	  tbl->u[id][ig] = su;
+	  tbl->eps[id][ig] = seps;
+	  for (int ip = 0; ip < TBLNP; ip++)
+	    for (int it = 0; it < TBLNT; it++)
+	      tbl->off[id][ig][ip][it] = (ip * TBLNT + it) * TBLNU;
+
+	  /* Read ASCII look-up tables... */
+	  if (ctl->tblfmt == 1)
+	    read_tbl_asc(ctl, tbl, id, ig);
+
+	  /* Read binary look-up tables... */
+	  else if (ctl->tblfmt == 2)
+	    read_tbl_bin(ctl, tbl, id, ig);
+
+	  /* Read per-gas look-up tables... */
+	  else if (ctl->tblfmt == 3)
+	    read_tbl_gas(ctl, &gas[ig], tbl, id, ig);
+
+	  /* Error message... */
+	  else
+	    ERRMSG("Unknown look-up table format!");
+
+	  /* Pack table block... */
+	  init_tbl_block(tbl, id, ig, su, seps);
+	}
+      }
+
+    /* Free... */
+    free(su);
+    free(seps);
+  }
+
+  /* Close per-gas look-up tables... */
+  for (int ig = 0; ig < ctl->ng; ig++)
+    if (gas[ig].fp)
+      read_tbl_gas_close(&gas[ig]);
+
+  /* Write info... */
+  for (int id = 0; id < ctl->nd; id++)
+    for (int ig = 0; ig < ctl->ng; ig++)
       for (int ip = 0; ip < tbl->np[id][ig]; ip++)
 	LOG(2,
 	    "p[%2d]= %.5e hPa | T[0:%2d]= %.2f ... %.2f K | u[0:%3d]= %.5e ... %.5e molec/cm^2 | eps[0:%3d]= %.5e ... %.5e",
 	    ip, tbl->p[id][ig][ip], tbl->nt[id][ig][ip] - 1,
 	    tbl->t[id][ig][ip][0],
 	    tbl->t[id][ig][ip][tbl->nt[id][ig][ip] - 1],
-	    tbl->nu[id][ig][ip][0] - 1, tbl->u[id][ig][ip][0][0],
-	    tbl->u[id][ig][ip][0][tbl->nu[id][ig][ip][0] - 1],
-	    tbl->nu[id][ig][ip][0] - 1, tbl->eps[id][ig][ip][0][0],
-	    tbl->eps[id][ig][ip][0][tbl->nu[id][ig][ip][0] - 1]);
-    }
+	    tbl->nu[id][ig][ip][0] - 1, TBL_U(tbl, id, ig, ip, 0)[0],
+	    TBL_U(tbl, id, ig, ip, 0)[tbl->nu[id][ig][ip][0] - 1],
+	    tbl->nu[id][ig][ip][0] - 1, TBL_EPS(tbl, id, ig, ip, 0)[0],
+	    TBL_EPS(tbl, id, ig, ip, 0)[tbl->nu[id][ig][ip][0] - 1]);
+
+  /* Group channels with identical pressure and temperature grids... */
+  init_tbl_group(ctl, tbl);
+
+  /* Quantise tables... */
+  if (ctl->tblquant)
+    init_tbl_quant(ctl, tbl);
+
+  /* Initialize guide tables... */
+  init_tbl_guide(ctl, tbl);
 
   /* Initialize source function... */
   init_srcfunc(ctl, tbl);
 
+  /* Initialize continuum coefficients... */
+  init_ctm(ctl, tbl);
+
   /* Return pointer... */
   return tbl;
 }
@@ -6004,15 +7735,12 @@ void read_tbl_asc(
     }
 
     /* Store data... */
-    tbl->p[id][ig][tbl->np[id][ig]] = press;
-    tbl->t[id][ig][tbl->np[id][ig]][tbl->nt[id][ig][tbl->np[id][ig]]]
-      = temp;
-    tbl->u[id][ig][tbl->np[id][ig]][tbl->nt[id][ig][tbl->np[id][ig]]]
-      [tbl->nu[id][ig][tbl->np[id][ig]]
-       [tbl->nt[id][ig][tbl->np[id][ig]]]] = (float) u;
-    tbl->eps[id][ig][tbl->np[id][ig]][tbl->nt[id][ig][tbl->np[id][ig]]]
-      [tbl->nu[id][ig][tbl->np[id][ig]]
-       [tbl->nt[id][ig][tbl->np[id][ig]]]] = (float) eps;
+    const int ip = tbl->np[id][ig];
+    const int it = tbl->nt[id][ig][ip];
+    tbl->p[id][ig][ip] = press;
+    tbl->t[id][ig][ip][it] = temp;
+    TBL_U(tbl, id, ig, ip, it)[tbl->nu[id][ig][ip][it]] = (float) u;
+    TBL_EPS(tbl, id, ig, ip, it)[tbl->nu[id][ig][ip][it]] = (float) eps;
   }
 
   /* Increment counters... */
@@ -6079,10 +7807,10 @@ void read_tbl_bin(
 	    in);
       if (tbl->nu[id][ig][ip][it] > TBLNU)
 	ERRMSG("Too many column densities!");
-      FREAD(tbl->u[id][ig][ip][it], float,
+      FREAD(TBL_U(tbl, id, ig, ip, it), float,
 	      (size_t) tbl->nu[id][ig][ip][it],
 	    in);
-      FREAD(tbl->eps[id][ig][ip][it], float,
+      FREAD(TBL_EPS(tbl, id, ig, ip, it), float,
 	      (size_t) tbl->nu[id][ig][ip][it],
 	    in);
     }
@@ -6096,30 +7824,19 @@ void read_tbl_bin(
 
 void read_tbl_gas(
   const ctl_t *ctl,
+  const tbl_gas_t *g,
   tbl_t *tbl,
   const int id,
   const int ig) {
 
-  /* Set filename... */
-  char filename[2 * LEN];
-  sprintf(filename, "%s_%s.tbl", ctl->tblbase, ctl->emitter[ig]);
-
-  /* Write info... */
-  LOG(1, "Read emissivity table: %s", filename);
-
-  /* Open file... */
-  tbl_gas_t gas;
-  if (read_tbl_gas_open(filename, &gas) != 0) {
-    WARN("Missing emissivity table: %s", filename);
+  /* Check file... */
+  if (!g->fp)
     return;
-  }
 
   /* Read table... */
-  if (read_tbl_gas_single(&gas, ctl->nu[id], tbl, id, ig) != 0)
-    WARN("Frequency %.6f missing in %s", ctl->nu[id], filename);
-
-  /* Close file... */
-  read_tbl_gas_close(&gas);
+  if (read_tbl_gas_single(g, ctl->nu[id], tbl, id, ig) != 0)
+    WARN("Frequency %.6f missing in %s_%s.tbl", ctl->nu[id],
+	 ctl->tblbase, ctl->emitter[ig]);
 }
 
 /*****************************************************************************/
@@ -6181,6 +7898,12 @@ int read_tbl_gas_open(
   FREAD(g->index, tbl_gas_index_t, MAX_TABLES, g->fp);
   g->dirty = 0;
 
+  /* Sort index by frequency... */
+  if (g->ntables < 0 || g->ntables > MAX_TABLES)
+    ERRMSG("Invalid gas-table file format!");
+  qsort(g->index, (size_t) g->ntables, sizeof(tbl_gas_index_t),
+	cmp_tbl_gas_index);
+
   return 0;
 }
 
@@ -6193,11 +7916,16 @@ int read_tbl_gas_single(
   const int id,
   const int ig) {
 
-  /* Find freq in index */
-  int idx = -1;
-  for (int i = 0; i < g->ntables; i++) {
-    if (g->index[i].freq == freq) {
-      idx = i;
+  /* Find frequency in sorted index... */
+  int lo = 0, hi = g->ntables - 1, idx = -1;
+  while (lo <= hi) {
+    const int mid = (lo + hi) / 2;
+    if (g->index[mid].freq < freq)
+      lo = mid + 1;
+    else if (g->index[mid].freq > freq)
+      hi = mid - 1;
+    else {
+      idx = mid;
       break;
     }
   }
@@ -6206,59 +7934,181 @@ int read_tbl_gas_single(
     return -1;
   }
 
-  /* Seek to table block... */
-  if (fseek(g->fp, (long) g->index[idx].offset, SEEK_SET) != 0)
-    ERRMSG("Seek error in read_tbl_gas_single!");
+  /* Read table block with a single positioned read... */
+  const size_t len = (size_t) g->index[idx].size;
+  char *buf;
+  ALLOC(buf, char,
+	len);
+  if (pread(fileno(g->fp), buf, len, (off_t) g->index[idx].offset)
+      != (ssize_t) len)
+    ERRMSG("Error while reading!");
+  size_t pos = 0;
 
   /* Read number of pressures... */
-  FREAD(&tbl->np[id][ig], int,
+  MREAD(&tbl->np[id][ig], int,
 	1,
-	g->fp);
+	buf, pos, len);
   if (tbl->np[id][ig] > TBLNP)
     ERRMSG("Too many pressure levels!");
 
   /* Read pressure grid... */
-  FREAD(tbl->p[id][ig], double,
-	  (size_t) tbl->np[id][ig],
-	g->fp);
+  MREAD(tbl->p[id][ig], double,
+	tbl->np[id][ig],
+	buf, pos, len);
 
   /* Loop over pressure levels... */
   for (int ip = 0; ip < tbl->np[id][ig]; ip++) {
 
     /* Read number of temperatures... */
-    FREAD(&tbl->nt[id][ig][ip], int,
+    MREAD(&tbl->nt[id][ig][ip], int,
 	  1,
-	  g->fp);
+	  buf, pos, len);
     if (tbl->nt[id][ig][ip] > TBLNT)
       ERRMSG("Too many temperatures!");
 
     /* Read temperature grid... */
-    FREAD(tbl->t[id][ig][ip], double,
-	    (size_t) tbl->nt[id][ig][ip],
-	  g->fp);
+    MREAD(tbl->t[id][ig][ip], double,
+	  tbl->nt[id][ig][ip],
+	  buf, pos, len);
 
     /* Loop over temperature levels... */
     for (int it = 0; it < tbl->nt[id][ig][ip]; it++) {
 
       /* Read number of u points... */
-      FREAD(&tbl->nu[id][ig][ip][it], int,
+      MREAD(&tbl->nu[id][ig][ip][it], int,
 	    1,
-	    g->fp);
+	    buf, pos, len);
       if (tbl->nu[id][ig][ip][it] > TBLNU)
 	ERRMSG("Too many column densities!");
 
       /* Read u grid... */
-      FREAD(tbl->u[id][ig][ip][it], float,
-	      (size_t) tbl->nu[id][ig][ip][it],
-	    g->fp);
+      MREAD(TBL_U(tbl, id, ig, ip, it), float,
+	    tbl->nu[id][ig][ip][it],
+	    buf, pos, len);
 
       /* Read emissivity grid... */
-      FREAD(tbl->eps[id][ig][ip][it], float,
-	      (size_t) tbl->nu[id][ig][ip][it],
-	    g->fp);
+      MREAD(TBL_EPS(tbl, id, ig, ip, it), float,
+	    tbl->nu[id][ig][ip][it],
+	    buf, pos, len);
+    }
+  }
+
+  /* Free... */
+  free(buf);
+
+  return 0;
+}
+
+/*****************************************************************************/
+
+void read_tbl_map(
+  const ctl_t *ctl,
+  tbl_t *tbl,
+  const int id,
+  const int ig) {
+
+  /* Check for missing table file... */
+  if (!tbl->map[ig])
+    return;
+
+  /* Get index... */
+  const tbl_map_hdr_t *hdr = (const tbl_map_hdr_t *) tbl->map[ig];
+  const tbl_gas_index_t *index =
+    (const tbl_gas_index_t *) (tbl->map[ig] + hdr->index);
+
+  /* Find frequency in sorted index... */
+  int lo = 0, hi = hdr->ntables - 1, idx = -1;
+  while (lo <= hi) {
+    const int mid = (lo + hi) / 2;
+    if (index[mid].freq < ctl->nu[id])
+      lo = mid + 1;
+    else if (index[mid].freq > ctl->nu[id])
+      hi = mid - 1;
+    else {
+      idx = mid;
+      break;
+    }
+  }
+  if (idx < 0) {
+    WARN("Frequency %.4f not found in gas table", ctl->nu[id]);
+    return;
+  }
+
+  /* Get table block... */
+  if (index[idx].offset < 0
+      || (size_t) index[idx].offset + sizeof(tbl_map_block_t)
+      > tbl->mapsize[ig])
+    ERRMSG("Invalid memory-mapped table file format!");
+  char *base = tbl->map[ig] + index[idx].offset;
+  const tbl_map_block_t *blk = (const tbl_map_block_t *) base;
+
+  /* Copy grids... */
+  if (blk->np < 0 || blk->np > TBLNP)
+    ERRMSG("Too many pressure levels!");
+  tbl->np[id][ig] = blk->np;
+  for (int ip = 0; ip < blk->np; ip++) {
+    if (blk->nt[ip] < 0 || blk->nt[ip] > TBLNT)
+      ERRMSG("Too many temperatures!");
+    tbl->p[id][ig][ip] = blk->p[ip];
+    tbl->nt[id][ig][ip] = blk->nt[ip];
+    for (int it = 0; it < blk->nt[ip]; it++) {
+      if (blk->nu[ip][it] < 0 || blk->nu[ip][it] > TBLNU)
+	ERRMSG("Too many column densities!");
+      tbl->t[id][ig][ip][it] = blk->t[ip][it];
+      tbl->nu[id][ig][ip][it] = blk->nu[ip][it];
     }
   }
 
+  /* Set offsets and check size of table block... */
+  const int n = init_tbl_block(tbl, id, ig, NULL, NULL);
+  if (n != blk->n || blk->u < 0 || blk->eps < 0
+      || (size_t) index[idx].offset + (size_t) MAX(blk->u, blk->eps)
+      + (size_t) n * sizeof(float) > tbl->mapsize[ig])
+    ERRMSG("Invalid memory-mapped table file format!");
+
+  /* Set pointers to mapped data... */
+  tbl->u[id][ig] = (float *) (base + blk->u);
+  tbl->eps[id][ig] = (float *) (base + blk->eps);
+}
+
+/*****************************************************************************/
+
+int read_tbl_map_open(
+  const char *filename,
+  tbl_t *tbl,
+  const int ig) {
+
+  /* Open file... */
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return -1;
+
+  /* Get file size... */
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    ERRMSG("Cannot get size of emissivity table!");
+  if ((size_t) st.st_size < sizeof(tbl_map_hdr_t))
+    ERRMSG("Invalid memory-mapped table file format!");
+
+  /* Map file (shared with other processes on the node)... */
+  void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    ERRMSG("Cannot map emissivity table!");
+  tbl->map[ig] = (char *) map;
+  tbl->mapsize[ig] = (size_t) st.st_size;
+
+  /* Check header... */
+  const tbl_map_hdr_t *hdr = (const tbl_map_hdr_t *) tbl->map[ig];
+  if (memcmp(hdr->magic, "JTM1", 4) != 0)
+    ERRMSG("Invalid memory-mapped table file format!");
+  if (hdr->tblnp != TBLNP || hdr->tblnt != TBLNT)
+    ERRMSG("Table dimensions (TBLNP, TBLNT) do not match!");
+  if (hdr->ntables < 0 || hdr->index < 0
+      || (size_t) hdr->index
+      + (size_t) hdr->ntables * sizeof(tbl_gas_index_t) > tbl->mapsize[ig])
+    ERRMSG("Invalid memory-mapped table file format!");
+
   return 0;
 }
 
@@ -6452,26 +8302,32 @@ void set_cov_meas(
   gsl_vector *sig_formod,
   gsl_vector *sig_eps_inv) {
 
-  static obs_t obs_err;
+  obs_t *obs_err;
 
   /* Get size... */
   const size_t m = sig_eps_inv->size;
 
+  /* Allocate... */
+  ALLOC(obs_err, obs_t, 1);
+
   /* Noise error (always considered in retrieval fit)... */
-  copy_obs(ctl, &obs_err, obs, 1);
-  for (int ir = 0; ir < obs_err.nr; ir++)
+  copy_obs(ctl, obs_err, obs, 1);
+  for (int ir = 0; ir < obs_err->nr; ir++)
     for (int id = 0; id < ctl->nd; id++)
-      obs_err.rad[id][ir]
+      obs_err->rad[id][ir]
 	= (isfinite(obs->rad[id][ir]) ? ret->err_noise[id] : NAN);
-  obs2y(ctl, &obs_err, sig_noise, NULL, NULL);
+  obs2y(ctl, obs_err, sig_noise, NULL, NULL);
 
   /* Forward model error (always considered in retrieval fit)... */
-  copy_obs(ctl, &obs_err, obs, 1);
-  for (int ir = 0; ir < obs_err.nr; ir++)
+  copy_obs(ctl, obs_err, obs, 1);
+  for (int ir = 0; ir < obs_err->nr; ir++)
     for (int id = 0; id < ctl->nd; id++)
-      obs_err.rad[id][ir]
+      obs_err->rad[id][ir]
 	= fabs(ret->err_formod[id] / 100 * obs->rad[id][ir]);
-  obs2y(ctl, &obs_err, sig_formod, NULL, NULL);
+  obs2y(ctl, obs_err, sig_formod, NULL, NULL);
+
+  /* Free... */
+  free(obs_err);
 
   /* Total error... */
   for (size_t i = 0; i < m; i++)
@@ -6574,6 +8430,8 @@ void timer(
 
   static int l0[10], nt;
 
+#pragma omp threadprivate(w0, l0, nt)
+
   /* Start new timer... */
   if (mode == 1) {
     w0[nt] = omp_get_wtime();
@@ -7250,6 +9108,55 @@ void write_shape(
 
 /*****************************************************************************/
 
+void write_srcfunc(
+  const char *filename,
+  const uint64_t hash,
+  const double *sr) {
+
+  const char magic[4] = { 'S', 'R', 'C', '1' };
+
+  const double tmin = TMIN, tmax = TMAX;
+
+  const int32_t ns = TBLNS;
+
+  /* Write info... */
+  LOG(1, "Write source function: %s", filename);
+
+  /* Create temporary file... */
+  char tmpfile[3 * LEN + 32];
+  sprintf(tmpfile, "%s.%ld.tmp", filename, (long) getpid());
+  FILE *out;
+  if (!(out = fopen(tmpfile, "w"))) {
+    WARN("Cannot create source function cache file: %s", filename);
+    return;
+  }
+
+  /* Write data... */
+  FWRITE(magic, char,
+	 4,
+	 out);
+  FWRITE(&hash, uint64_t, 1, out);
+  FWRITE(&ns, int32_t, 1, out);
+  FWRITE(&tmin, double,
+	 1,
+	 out);
+  FWRITE(&tmax, double,
+	 1,
+	 out);
+  FWRITE(sr, double,
+	 TBLNS,
+	 out);
+
+  /* Close file and move it into place... */
+  fclose(out);
+  if (rename(tmpfile, filename) != 0) {
+    WARN("Cannot create source function cache file: %s", filename);
+    remove(tmpfile);
+  }
+}
+
+/*****************************************************************************/
+
 void write_stddev(
   const char *quantity,
   const ret_t *ret,
@@ -7257,7 +9164,7 @@ void write_stddev(
   const atm_t *atm,
   const gsl_matrix *s) {
 
-  static atm_t atm_aux;
+  atm_t *atm_aux;
 
   char filename[LEN];
 
@@ -7265,6 +9172,7 @@ void write_stddev(
   const size_t n = s->size1;
 
   /* Allocate... */
+  ALLOC(atm_aux, atm_t, 1);
   gsl_vector *x_aux = gsl_vector_alloc(n);
 
   /* Compute standard deviation... */
@@ -7272,12 +9180,13 @@ void write_stddev(
     gsl_vector_set(x_aux, i, sqrt(gsl_matrix_get(s, i, i)));
 
   /* Write to disk... */
-  copy_atm(ctl, &atm_aux, atm, 1);
-  x2atm(ctl, x_aux, &atm_aux);
+  copy_atm(ctl, atm_aux, atm, 1);
+  x2atm(ctl, x_aux, atm_aux);
   sprintf(filename, "atm_err_%s.tab", quantity);
-  write_atm(ret->dir, filename, ctl, &atm_aux);
+  write_atm(ret->dir, filename, ctl, atm_aux);
 
   /* Free... */
+  free(atm_aux);
   gsl_vector_free(x_aux);
 }
 
@@ -7287,6 +9196,10 @@ void write_tbl(
   const ctl_t *ctl,
   const tbl_t *tbl) {
 
+  /* Check for quantised tables... */
+  if (tbl->quant)
+    ERRMSG("Cannot write quantised look-up tables!");
+
   /* Write ASCII look-up tables... */
   if (ctl->tblfmt == 1)
     write_tbl_asc(ctl, tbl);
@@ -7299,6 +9212,10 @@ void write_tbl(
   else if (ctl->tblfmt == 3)
     write_tbl_gas(ctl, tbl);
 
+  /* Write memory-mapped look-up tables... */
+  else if (ctl->tblfmt == 4)
+    write_tbl_map(ctl, tbl);
+
   /* Error message... */
   else
     ERRMSG("Unknown look-up table format!");
@@ -7341,7 +9258,8 @@ void write_tbl_asc(
 	  for (int iu = 0; iu < tbl->nu[id][ig][ip][it]; iu++)
 	    fprintf(out, "%g %g %e %e\n",
 		    tbl->p[id][ig][ip], tbl->t[id][ig][ip][it],
-		    tbl->u[id][ig][ip][it][iu], tbl->eps[id][ig][ip][it][iu]);
+		    TBL_U(tbl, id, ig, ip, it)[iu],
+		    TBL_EPS(tbl, id, ig, ip, it)[iu]);
 	}
 
       /* Close file... */
@@ -7390,10 +9308,10 @@ void write_tbl_bin(
 	  FWRITE(&tbl->nu[id][ig][ip][it], int,
 		 1,
 		 out);
-	  FWRITE(tbl->u[id][ig][ip][it], float,
+	  FWRITE(TBL_U(tbl, id, ig, ip, it), float,
 		   (size_t) tbl->nu[id][ig][ip][it],
 		 out);
-	  FWRITE(tbl->eps[id][ig][ip][it], float,
+	  FWRITE(TBL_EPS(tbl, id, ig, ip, it), float,
 		   (size_t) tbl->nu[id][ig][ip][it],
 		 out);
 	}
@@ -7545,12 +9463,12 @@ int write_tbl_gas_single(
 	     g->fp);
 
       /* Write u array... */
-      FWRITE(tbl->u[id][ig][ip][it], float,
+      FWRITE(TBL_U(tbl, id, ig, ip, it), float,
 	       (size_t) tbl->nu[id][ig][ip][it],
 	     g->fp);
 
       /* Write emissivity array... */
-      FWRITE(tbl->eps[id][ig][ip][it], float,
+      FWRITE(TBL_EPS(tbl, id, ig, ip, it), float,
 	       (size_t) tbl->nu[id][ig][ip][it],
 	     g->fp);
     }
@@ -7574,6 +9492,137 @@ int write_tbl_gas_single(
 
 /*****************************************************************************/
 
+void write_tbl_map(
+  const ctl_t *ctl,
+  const tbl_t *tbl) {
+
+  const char zero[TBLALIGN] = { 0 };
+
+  tbl_gas_index_t *index;
+
+  /* Allocate... */
+  ALLOC(index, tbl_gas_index_t, ctl->nd);
+
+  /* Loop over emitters... */
+  for (int ig = 0; ig < ctl->ng; ig++) {
+
+    /* Set filename... */
+    char filename[2 * LEN];
+    sprintf(filename, "%s_%s.map", ctl->tblbase, ctl->emitter[ig]);
+
+    /* Write info... */
+    LOG(1, "Write emissivity table: %s", filename);
+
+    /* Set file layout... */
+    tbl_map_hdr_t hdr = { {'J', 'T', 'M', '1'}, ctl->nd, TBLNP, TBLNT,
+      TBL_ALIGN((int64_t) sizeof(tbl_map_hdr_t))
+    };
+    int64_t offset = TBL_ALIGN(hdr.index
+			       + ctl->nd
+			       * (int64_t) sizeof(tbl_gas_index_t));
+    for (int id = 0; id < ctl->nd; id++) {
+      int64_t n = 0;
+      for (int ip = 0; ip < tbl->np[id][ig]; ip++)
+	for (int it = 0; it < tbl->nt[id][ig][ip]; it++)
+	  n += MAX(tbl->nu[id][ig][ip][it], 0);
+      const int64_t u = TBL_ALIGN((int64_t) sizeof(tbl_map_block_t));
+      const int64_t eps = TBL_ALIGN(u + n * (int64_t) sizeof(float));
+      index[id].freq = ctl->nu[id];
+      index[id].offset = offset;
+      index[id].size = TBL_ALIGN(eps + n * (int64_t) sizeof(float));
+      offset += index[id].size;
+    }
+
+    /* Sort index by frequency... */
+    tbl_gas_index_t *sorted;
+    ALLOC(sorted, tbl_gas_index_t, ctl->nd);
+    memcpy(sorted, index, (size_t) ctl->nd * sizeof(tbl_gas_index_t));
+    qsort(sorted, (size_t) ctl->nd, sizeof(tbl_gas_index_t),
+	  cmp_tbl_gas_index);
+    for (int i = 1; i < ctl->nd; i++)
+      if (sorted[i].freq == sorted[i - 1].freq)
+	ERRMSG("Duplicate channel frequencies!");
+
+    /* Create file... */
+    FILE *out;
+    if (!(out = fopen(filename, "w")))
+      ERRMSG("Cannot create file!");
+
+    /* Write header and index... */
+    FWRITE(&hdr, tbl_map_hdr_t, 1, out);
+    FWRITE(zero, char,
+	     (size_t) hdr.index - sizeof(tbl_map_hdr_t),
+	   out);
+    FWRITE(sorted, tbl_gas_index_t, (size_t) ctl->nd, out);
+    free(sorted);
+
+    /* Loop over channels... */
+    for (int id = 0; id < ctl->nd; id++) {
+
+      /* Write padding... */
+      size_t pad = (size_t) (index[id].offset - ftell(out));
+      FWRITE(zero, char,
+	     pad,
+	     out);
+
+      /* Set block header... */
+      tbl_map_block_t blk;
+      memset(&blk, 0, sizeof(blk));
+      blk.np = MAX(tbl->np[id][ig], 0);
+      for (int ip = 0; ip < blk.np; ip++) {
+	blk.p[ip] = tbl->p[id][ig][ip];
+	blk.nt[ip] = tbl->nt[id][ig][ip];
+	for (int it = 0; it < blk.nt[ip]; it++) {
+	  blk.t[ip][it] = tbl->t[id][ig][ip][it];
+	  blk.nu[ip][it] = MAX(tbl->nu[id][ig][ip][it], 0);
+	  blk.n += blk.nu[ip][it];
+	}
+      }
+      blk.u = TBL_ALIGN((int64_t) sizeof(tbl_map_block_t));
+      blk.eps = TBL_ALIGN(blk.u + blk.n * (int64_t) sizeof(float));
+
+      /* Write block header... */
+      FWRITE(&blk, tbl_map_block_t, 1, out);
+
+      /* Write column densities... */
+      pad = (size_t) (index[id].offset + blk.u - ftell(out));
+      FWRITE(zero, char,
+	     pad,
+	     out);
+      for (int ip = 0; ip < blk.np; ip++)
+	for (int it = 0; it < blk.nt[ip]; it++)
+	  FWRITE(TBL_U(tbl, id, ig, ip, it), float,
+		   (size_t) blk.nu[ip][it],
+		 out);
+
+      /* Write emissivities... */
+      pad = (size_t) (index[id].offset + blk.eps - ftell(out));
+      FWRITE(zero, char,
+	     pad,
+	     out);
+      for (int ip = 0; ip < blk.np; ip++)
+	for (int it = 0; it < blk.nt[ip]; it++)
+	  FWRITE(TBL_EPS(tbl, id, ig, ip, it), float,
+		   (size_t) blk.nu[ip][it],
+		 out);
+    }
+
+    /* Write padding... */
+    const size_t pad = (size_t) (offset - ftell(out));
+    FWRITE(zero, char,
+	   pad,
+	   out);
+
+    /* Close file... */
+    fclose(out);
+  }
+
+  /* Free... */
+  free(index);
+}
+
+/*****************************************************************************/
+
 void x2atm(
   const ctl_t *ctl,
   const gsl_vector *x,
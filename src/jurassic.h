@@ -105,6 +105,7 @@
    ------------------------------------------------------------ */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_linalg.h>
@@ -117,7 +118,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 /* ------------------------------------------------------------
    Constants...
@@ -317,6 +321,21 @@
 #define TBLNS 1200
 #endif
 
+/*! Number of bins of the guide tables for emissivity table lookups. */
+#ifndef TBLNB
+#define TBLNB 32
+#endif
+
+/*! Alignment of blocks in memory-mapped table files [bytes]. */
+#ifndef TBLALIGN
+#define TBLALIGN 64
+#endif
+
+/*! Maximum value of quantised emissivity table data. */
+#ifndef TBLQMAX
+#define TBLQMAX 65535
+#endif
+
 /*! Maximum number of frequency-table entries allowed in a gas table file. */
 #ifndef MAX_TABLES
 #define MAX_TABLES 10000
@@ -630,6 +649,30 @@
  */
 #define MIN(a,b) (((a)<(b))?(a):(b))
 
+/**
+ * @brief Read data from a memory buffer with bounds checking.
+ *
+ * Copies `size` elements of type `type` from position `pos` of the
+ * buffer `buf` of length `len` bytes to `ptr` and advances `pos`.
+ * Counterpart of FREAD() for data that have been read into memory.
+ *
+ * @param ptr   Pointer to the destination.
+ * @param type  Data type of the elements.
+ * @param size  Number of elements.
+ * @param buf   Source buffer.
+ * @param pos   Current position in the buffer [bytes] (updated).
+ * @param len   Length of the buffer [bytes].
+ *
+ * @warning Aborts via ERRMSG() if the buffer is exhausted.
+ */
+#define MREAD(ptr, type, size, buf, pos, len) {				\
+    const size_t mread_n = sizeof(type) * (size_t) (size);		\
+    if((pos) + mread_n > (len))						\
+      ERRMSG("Error while reading!");					\
+    memcpy(ptr, (buf) + (pos), mread_n);				\
+    (pos) += mread_n;							\
+  }
+
 /**
  * @brief Convert noise-equivalent spectral radiance (NESR) to
  *        noise-equivalent delta temperature (NEDT).
@@ -797,6 +840,135 @@
  */
 #define REFRAC(p, T) (7.753e-05 * (p) / (T))
 
+/**
+ * @brief Round up a file offset to the table block alignment.
+ *
+ * Returns the smallest multiple of @ref TBLALIGN that is greater than or
+ * equal to the given offset. Used for the layout of memory-mapped
+ * table files.
+ *
+ * @param[in] x  File offset [bytes].
+ *
+ * @return Aligned file offset [bytes].
+ *
+ * @see write_tbl_map, read_tbl_map
+ */
+#define TBL_ALIGN(x)						\
+  ((((x) + TBLALIGN - 1) / TBLALIGN) * TBLALIGN)
+
+/**
+ * @brief Dequantise an emissivity of a quantised emissivity table.
+ *
+ * Emissivities are quantised on a logit scale,
+ * \f$ \ln(\varepsilon / (1 - \varepsilon)) = s_0 + q s_1 \f$,
+ * which resolves both small emissivities and emissivities close to one.
+ *
+ * @param[in] es  Offset and scaling factor of the table (@ref tbl_t::epsqs).
+ * @param[in] q   Quantised emissivity.
+ *
+ * @return Emissivity [-].
+ *
+ * @see TBL_DEQ_U, init_tbl_quant, intpol_tbl_eps_q, intpol_tbl_u_q
+ */
+#define TBL_DEQ_EPS(es, q)				\
+  (1.0 / (1.0 + exp(-((es)[0] + (q) * (es)[1]))))
+
+/**
+ * @brief Dequantise a column density of a quantised emissivity table.
+ *
+ * Column densities are quantised on a log scale,
+ * \f$ \ln u = s_0 + q s_1 \f$.
+ *
+ * @param[in] us  Offset and scaling factor of the table (@ref tbl_t::uqs).
+ * @param[in] q   Quantised column density.
+ *
+ * @return Column density [molecules/cm^2].
+ *
+ * @see TBL_DEQ_EPS, init_tbl_quant, intpol_tbl_eps_q, intpol_tbl_u_q
+ */
+#define TBL_DEQ_U(us, q)			\
+  exp((us)[0] + (q) * (us)[1])
+
+/**
+ * @brief Get emissivity data of an emissivity table.
+ *
+ * Returns a pointer to the emissivity values of the table for the given
+ * channel, emitter, pressure level, and temperature within the packed
+ * table block of the channel and emitter.
+ *
+ * @param[in] tbl  Emissivity lookup tables (@ref tbl_t).
+ * @param[in] id   Channel index.
+ * @param[in] ig   Emitter index.
+ * @param[in] ip   Pressure level index.
+ * @param[in] it   Temperature index.
+ *
+ * @return Pointer to `tbl->nu[id][ig][ip][it]` emissivity values.
+ *
+ * @see TBL_U, tbl_t, init_tbl_block
+ */
+#define TBL_EPS(tbl, id, ig, ip, it)				\
+  ((tbl)->eps[id][ig] + (tbl)->off[id][ig][ip][it])
+
+/**
+ * @brief Get quantised emissivity data of an emissivity table.
+ *
+ * Returns a pointer to the quantised emissivities of the table for the
+ * given channel, emitter, pressure level, and temperature within the
+ * packed table block (see init_tbl_quant()).
+ *
+ * @param[in] tbl  Emissivity lookup tables (@ref tbl_t).
+ * @param[in] id   Channel index.
+ * @param[in] ig   Emitter index.
+ * @param[in] ip   Pressure level index.
+ * @param[in] it   Temperature index.
+ *
+ * @return Pointer to `tbl->nu[id][ig][ip][it]` quantised emissivities.
+ *
+ * @see TBL_UQ, tbl_t, init_tbl_quant
+ */
+#define TBL_EPSQ(tbl, id, ig, ip, it)				\
+  ((tbl)->epsq[id][ig] + (tbl)->off[id][ig][ip][it])
+
+/**
+ * @brief Get column density data of an emissivity table.
+ *
+ * Returns a pointer to the column densities of the table for the given
+ * channel, emitter, pressure level, and temperature within the packed
+ * table block of the channel and emitter.
+ *
+ * @param[in] tbl  Emissivity lookup tables (@ref tbl_t).
+ * @param[in] id   Channel index.
+ * @param[in] ig   Emitter index.
+ * @param[in] ip   Pressure level index.
+ * @param[in] it   Temperature index.
+ *
+ * @return Pointer to `tbl->nu[id][ig][ip][it]` column densities.
+ *
+ * @see TBL_EPS, tbl_t, init_tbl_block
+ */
+#define TBL_U(tbl, id, ig, ip, it)				\
+  ((tbl)->u[id][ig] + (tbl)->off[id][ig][ip][it])
+
+/**
+ * @brief Get quantised column density data of an emissivity table.
+ *
+ * Returns a pointer to the quantised (log-scaled) column densities of
+ * the table for the given channel, emitter, pressure level, and
+ * temperature within the packed table block (see init_tbl_quant()).
+ *
+ * @param[in] tbl  Emissivity lookup tables (@ref tbl_t).
+ * @param[in] id   Channel index.
+ * @param[in] ig   Emitter index.
+ * @param[in] ip   Pressure level index.
+ * @param[in] it   Temperature index.
+ *
+ * @return Pointer to `tbl->nu[id][ig][ip][it]` quantised column densities.
+ *
+ * @see TBL_EPSQ, tbl_t, init_tbl_quant
+ */
+#define TBL_UQ(tbl, id, ig, ip, it)				\
+  ((tbl)->uq[id][ig] + (tbl)->off[id][ig][ip][it])
+
 /**
  * @brief Start or stop a named timer.
  *
@@ -1101,9 +1273,15 @@ typedef struct {
   /*! Basename for table files and filter function files. */
   char tblbase[LEN];
 
-  /*! Look-up table file format (1=ASCII, 2=binary). */
+  /*! Look-up table file format (1=ASCII, 2=binary, 3=per-gas, 4=mmap). */
   int tblfmt;
 
+  /*! Quantised look-up tables (0=no, 1=yes). */
+  int tblquant;
+
+  /*! Directory of source function cache files (- = no cache). */
+  char srccache[LEN];
+
   /*! Atmospheric data file format (1=ASCII, 2=binary). */
   int atmfmt;
 
@@ -1205,6 +1383,36 @@ typedef struct {
 
 } ctl_t;
 
+/**
+ * @brief Line-of-sight geometry.
+ *
+ * Stores the sampled ray path of a single line of sight. Without
+ * refraction, the geometry does not depend on the atmospheric state
+ * and can be reused when only the atmospheric data change (e.g. for
+ * the columns of the Jacobian matrix).
+ */
+typedef struct {
+
+  /*! Number of LOS points. */
+  int np;
+
+  /*! Flag for LOS hitting the ground. */
+  int ground;
+
+  /*! Altitude [km]. */
+  double z[NLOS];
+
+  /*! Longitude [deg]. */
+  double lon[NLOS];
+
+  /*! Latitude [deg]. */
+  double lat[NLOS];
+
+  /*! Segment length [km]. */
+  double ds[NLOS];
+
+} geo_t;
+
 /**
  * @brief Line-of-sight data.
  *
@@ -1407,6 +1615,9 @@ typedef struct {
  *
  * Stores precomputed emissivity and source-function data for
  * different gases, spectral channels, and emitter column densities.
+ * The column densities, emissivities, and guide tables of each channel
+ * and emitter are stored in packed blocks sized to the actual table
+ * grids (see init_tbl_block, TBL_U, TBL_EPS).
  */
 typedef struct {
 
@@ -1425,11 +1636,56 @@ typedef struct {
   /*! Temperature [K]. */
   double t[ND][NG][TBLNP][TBLNT];
 
-  /*! Column density [molecules/cm^2]. */
-  float u[ND][NG][TBLNP][TBLNT][TBLNU];
+  /*! Offset of table data in packed table block. */
+  int off[ND][NG][TBLNP][TBLNT];
+
+  /*! Index of table in packed table block. */
+  int itab[ND][NG][TBLNP][TBLNT];
+
+  /*! Number of tables in packed table block. */
+  int ntab[ND][NG];
 
-  /*! Emissivity. */
-  float eps[ND][NG][TBLNP][TBLNT][TBLNU];
+  /*! Column density [molecules/cm^2] (packed table block). */
+  float *u[ND][NG];
+
+  /*! Emissivity (packed table block). */
+  float *eps[ND][NG];
+
+  /*! Guide tables for column density lookups (log-spaced bins). */
+  unsigned short *ugd[ND][NG];
+
+  /*! Guide tables for emissivity lookups (regular bins). */
+  unsigned short *epsgd[ND][NG];
+
+  /*! Bin scaling factors of column density guide tables. */
+  double *ugds[ND][NG];
+
+  /*! Bin scaling factors of emissivity guide tables. */
+  double *epsgds[ND][NG];
+
+  /*! Quantised tables (0=no, 1=yes). */
+  int quant;
+
+  /*! Quantised column densities (log-scaled, packed table block). */
+  unsigned short *uq[ND][NG];
+
+  /*! Quantised emissivities (logit-scaled, packed table block). */
+  unsigned short *epsq[ND][NG];
+
+  /*! Offsets and scaling factors of quantised column densities. */
+  double *uqs[ND][NG];
+
+  /*! Offsets and scaling factors of quantised emissivities. */
+  double *epsqs[ND][NG];
+
+  /*! Reference channel with identical pressure and temperature grids. */
+  int ref[ND][NG];
+
+  /*! Memory-mapped table file of each emitter (read-only, or NULL). */
+  char *map[NG];
+
+  /*! Size of memory-mapped table file of each emitter [bytes]. */
+  size_t mapsize[NG];
 
   /*! Source function temperature [K]. */
   double st[TBLNS];
@@ -1437,6 +1693,18 @@ typedef struct {
   /*! Source function radiance [W/(m^2 sr cm^-1)]. */
   double sr[TBLNS][ND];
 
+  /*! CO2 continuum coefficients (see ctmco2_coeff). */
+  double ctm_co2[3][ND];
+
+  /*! H2O continuum coefficients (see ctmh2o_coeff). */
+  double ctm_h2o[5][ND];
+
+  /*! N2 continuum coefficients (see ctmn2_coeff). */
+  double ctm_n2[2][ND];
+
+  /*! O2 continuum coefficients (see ctmo2_coeff). */
+  double ctm_o2[2][ND];
+
 } tbl_t;
 
 /**
@@ -1481,6 +1749,89 @@ typedef struct {
 
 } tbl_gas_t;
 
+/**
+ * @brief Table block header of a memory-mapped table file.
+ *
+ * Holds the pressure and temperature grids and the numbers of column
+ * densities of all emissivity tables of one channel. The column
+ * densities and emissivities follow as packed float arrays (see
+ * init_tbl_block) at the given offsets from the start of the block,
+ * aligned to @ref TBLALIGN bytes.
+ */
+typedef struct {
+
+  /*! Number of pressure levels. */
+  int32_t np;
+
+  /*! Number of temperatures. */
+  int32_t nt[TBLNP];
+
+  /*! Number of column densities. */
+  int32_t nu[TBLNP][TBLNT];
+
+  /*! Total number of column densities in packed table block. */
+  int64_t n;
+
+  /*! Offset of column densities from start of block [bytes]. */
+  int64_t u;
+
+  /*! Offset of emissivities from start of block [bytes]. */
+  int64_t eps;
+
+  /*! Pressure [hPa]. */
+  double p[TBLNP];
+
+  /*! Temperature [K]. */
+  double t[TBLNP][TBLNT];
+
+} tbl_map_block_t;
+
+/**
+ * @brief File header of a memory-mapped table file.
+ *
+ * The header is followed by an index of `ntables` entries sorted by
+ * frequency (see @ref tbl_gas_index_t) and the table blocks (see
+ * @ref tbl_map_block_t), all aligned to @ref TBLALIGN bytes.
+ */
+typedef struct {
+
+  /*! File format identifier ("JTM1"). */
+  char magic[4];
+
+  /*! Number of table blocks. */
+  int32_t ntables;
+
+  /*! Maximum number of pressure levels (TBLNP) used for writing. */
+  int32_t tblnp;
+
+  /*! Maximum number of temperatures (TBLNT) used for writing. */
+  int32_t tblnt;
+
+  /*! Offset of index from start of file [bytes]. */
+  int64_t index;
+
+} tbl_map_hdr_t;
+
+/**
+ * @brief Warm-start data for optimal estimation.
+ *
+ * Holds the retrieved state vector and the kernel matrix of a previous
+ * retrieval, which are used as first guess for a neighbouring
+ * measurement (see optimal_estimation_warm()).
+ */
+typedef struct {
+
+  /*! Warm-start data are valid (0=no, 1=yes). */
+  int valid;
+
+  /*! State vector of previous retrieval. */
+  gsl_vector *x;
+
+  /*! Kernel matrix of previous retrieval. */
+  gsl_matrix *k;
+
+} warm_t;
+
 /* ------------------------------------------------------------
    Functions...
    ------------------------------------------------------------ */
@@ -1710,6 +2061,24 @@ void climatology(
   const ctl_t * ctl,
   atm_t * atm);
 
+/**
+ * @brief Compare two gas-table index entries by frequency.
+ *
+ * Comparison function for qsort() to sort the index of a per-gas or
+ * memory-mapped table file by ascending frequency.
+ *
+ * @param a  Pointer to first index entry (@ref tbl_gas_index_t).
+ * @param b  Pointer to second index entry (@ref tbl_gas_index_t).
+ *
+ * @return Negative, zero, or positive value if the frequency of the
+ *         first entry is smaller, equal, or larger.
+ *
+ * @see read_tbl_gas_open, write_tbl_map
+ */
+int cmp_tbl_gas_index(
+  const void *a,
+  const void *b);
+
 /**
  * @brief Calculates the cosine of the solar zenith angle.
  *
@@ -1795,6 +2164,22 @@ double ctmco2(
   const double t,
   const double u);
 
+/**
+ * @brief Get spectral coefficients of the carbon dioxide continuum.
+ *
+ * Interpolates the tabulated continuum at 230, 260, and 296 K to the
+ * given wavenumber. The coefficients are scaled such that the
+ * temperature dependence is a quadratic polynomial in T (see ctmco2).
+ *
+ * @param[in]  nu  Wavenumber [cm⁻¹].
+ * @param[out] c   Coefficients (3 values, zero outside the tabulated range).
+ *
+ * @see ctmco2, init_ctm
+ */
+void ctmco2_coeff(
+  const double nu,
+  double *c);
+
 /**
  * @brief Compute water vapor continuum (optical depth).
  *
@@ -1807,6 +2192,22 @@ double ctmh2o(
   const double q,
   const double u);
 
+/**
+ * @brief Get spectral coefficients of the water vapor continuum.
+ *
+ * Returns the scaled self-continuum at 296 K, the logarithmic
+ * temperature slope of the self-continuum, the scaled foreign
+ * continuum, the wavenumber, and the radiation term factor.
+ *
+ * @param[in]  nu  Wavenumber [cm⁻¹].
+ * @param[out] c   Coefficients (5 values, zero outside the tabulated range).
+ *
+ * @see ctmh2o, init_ctm
+ */
+void ctmh2o_coeff(
+  const double nu,
+  double *c);
+
 /**
  * @brief Compute N₂ collision-induced absorption coefficient.
  *
@@ -1841,6 +2242,21 @@ double ctmn2(
   const double p,
   const double t);
 
+/**
+ * @brief Get spectral coefficients of the N₂ continuum.
+ *
+ * Interpolates the absorption strength B (scaled by the N₂ volume
+ * mixing ratio) and the temperature exponent β to the given wavenumber.
+ *
+ * @param[in]  nu  Wavenumber [cm⁻¹].
+ * @param[out] c   Coefficients (2 values, zero outside the tabulated range).
+ *
+ * @see ctmn2, init_ctm
+ */
+void ctmn2_coeff(
+  const double nu,
+  double *c);
+
 /**
  * @brief Compute O₂ collision-induced absorption coefficient.
  *
@@ -1875,6 +2291,21 @@ double ctmo2(
   const double p,
   const double t);
 
+/**
+ * @brief Get spectral coefficients of the O₂ continuum.
+ *
+ * Interpolates the absorption strength B (scaled by the O₂ volume
+ * mixing ratio) and the temperature exponent β to the given wavenumber.
+ *
+ * @param[in]  nu  Wavenumber [cm⁻¹].
+ * @param[out] c   Coefficients (2 values, zero outside the tabulated range).
+ *
+ * @see ctmo2, init_ctm
+ */
+void ctmo2_coeff(
+  const double nu,
+  double *c);
+
 /**
  * @brief Copy or initialize atmospheric profile data.
  *
@@ -2052,9 +2483,12 @@ void formod(
  *
  * The function updates the extinction array @p beta for each spectral
  * channel based on line-by-line extinction and enabled continua flags
- * specified in @p ctl.
+ * specified in @p ctl. The spectral coefficients of the continua are
+ * taken from @p tbl (see init_ctm), so that only the pressure and
+ * temperature dependence is evaluated at each point.
  *
  * @param[in]  ctl  Control structure defining model setup and continuum options.
+ * @param[in]  tbl  Look-up tables with continuum coefficients per channel.
  * @param[in]  los  Line-of-sight data containing pressure, temperature,
  *                  gas concentrations, and extinction coefficients.
  * @param[in]  ip   Index of the line-of-sight point to process.
@@ -2064,16 +2498,46 @@ void formod(
  *       control flag (e.g., @ref ctl_t::ctm_co2, @ref ctl_t::ctm_h2o)
  *       is enabled and the gas index is valid.
  *
- * @see ctl_t, los_t, ctmco2, ctmh2o, ctmn2, ctmo2
+ * @see ctl_t, los_t, ctmco2, ctmh2o, ctmn2, ctmo2, init_ctm
  * 
  * @author Lars Hoffmann
  */
 void formod_continua(
   const ctl_t * ctl,
+  const tbl_t * tbl,
   const los_t * los,
   const int ip,
   double *beta);
 
+/**
+ * @brief Compute extinction and continua with tangent-linear derivatives.
+ *
+ * Evaluates the total extinction coefficient of one channel at one LOS
+ * point (aerosol/cloud extinction plus the CO2, H2O, N2, and O2
+ * continua, as in formod_continua) together with its partial
+ * derivatives.
+ *
+ * @param[in]  ctl    Control structure (continua flags, emitter indices).
+ * @param[in]  tbl    Emissivity lookup tables (continuum coefficients).
+ * @param[in]  los    Line-of-sight data.
+ * @param[in]  ip     LOS point index.
+ * @param[in]  id     Channel index.
+ * @param[out] beta   Total extinction coefficient [km⁻¹].
+ * @param[out] dbeta  Derivatives of `beta` with respect to temperature,
+ *                    pressure, CO2 column density, H2O column density,
+ *                    and H2O volume mixing ratio (5 elements).
+ *
+ * @see formod_continua, kernel_analytic
+ */
+void formod_continua_tl(
+  const ctl_t * ctl,
+  const tbl_t * tbl,
+  const los_t * los,
+  const int ip,
+  const int id,
+  double *beta,
+  double *dbeta);
+
 /**
  * @brief Apply field-of-view (FOV) convolution to modeled radiances.
  *
@@ -2099,6 +2563,28 @@ void formod_fov(
   const ctl_t * ctl,
   obs_t * obs);
 
+/**
+ * @brief Execute the forward model with optional cached LOS geometry.
+ *
+ * Same as @ref formod, but for the CGA/EGA forward model the ray
+ * paths can be taken from precomputed geometry instead of being traced
+ * again. The geometry is only used if refraction is switched off.
+ *
+ * @param[in]     ctl  Control structure defining model setup.
+ * @param[in]     tbl  Emissivity lookup tables.
+ * @param[in,out] atm  Atmospheric profile data.
+ * @param[in,out] obs  Observation geometry and radiance data.
+ * @param[in]     geo  LOS geometry of each ray path (or NULL).
+ *
+ * @see formod, formod_pencil, raytrace_geo, kernel
+ */
+void formod_geo(
+  const ctl_t * ctl,
+  const tbl_t * tbl,
+  atm_t * atm,
+  obs_t * obs,
+  const geo_t * geo);
+
 /**
  * @brief Compute line-of-sight radiances using the pencil-beam forward model.
  *
@@ -2115,12 +2601,16 @@ void formod_fov(
  * @param[in,out] obs  Observation data; updated with modeled radiances and
  *                     transmittances for the specified ray path.
  * @param[in]  ir   Index of the current ray path in @p obs.
+ * @param[in]  geo  Cached LOS geometry of the ray path (or NULL to
+ *                  trace the ray with @ref raytrace()).
  *
  * @note Depending on @ref ctl_t::formod, this function calls either
  *       @ref intpol_tbl_cga() (CGA) or @ref intpol_tbl_ega() (EGA)
  *       for gas absorption interpolation.  
  *       Surface effects include emission, reflection, and—if enabled—
  *       solar illumination based on the solar zenith angle.
+ *       The LOS workspace is allocated once per thread and reused
+ *       for subsequent calls.
  *
  * @see ctl_t, atm_t, obs_t, tbl_t, los_t,
  *      raytrace, formod_continua, formod_srcfunc,
@@ -2133,7 +2623,8 @@ void formod_pencil(
   const tbl_t * tbl,
   const atm_t * atm,
   obs_t * obs,
-  const int ir);
+  const int ir,
+  const geo_t * geo);
 
 /**
  * @brief Interface routine for the Reference Forward Model (RFM).
@@ -2208,6 +2699,22 @@ void formod_srcfunc(
   const double t,
   double *src);
 
+/**
+ * @brief Free emissivity look-up tables.
+ *
+ * Releases the packed table blocks, guide tables, and quantised tables
+ * allocated by read_tbl(), unmaps memory-mapped table files, and frees
+ * the table structure itself.
+ *
+ * @param ctl  Control structure (number of channels and emitters).
+ * @param tbl  Look-up tables returned by read_tbl() (or NULL).
+ *
+ * @see read_tbl
+ */
+void free_tbl(
+  const ctl_t * ctl,
+  tbl_t * tbl);
+
 /**
  * @brief Converts geographic coordinates (longitude, latitude, altitude) to Cartesian coordinates.
  *
@@ -2240,6 +2747,26 @@ void geo2cart(
   const double lat,
   double *x);
 
+/**
+ * @brief Compute 64-bit FNV-1a hash of a data buffer.
+ *
+ * Updates the given hash value with the bytes of the buffer, so that
+ * several buffers can be hashed in sequence. Start with the FNV offset
+ * basis `14695981039346656037ULL`.
+ *
+ * @param[in] data  Pointer to the data buffer.
+ * @param[in] n     Size of the data buffer [bytes].
+ * @param[in] hash  Hash value of the preceding buffers.
+ *
+ * @return Updated hash value.
+ *
+ * @see init_srcfunc
+ */
+uint64_t hash_fnv1a(
+  const void *data,
+  const size_t n,
+  uint64_t hash);
+
 /**
  * @brief Adjust pressure profile using the hydrostatic equation.
  *
@@ -2299,6 +2826,23 @@ void idx2name(
   const int idx,
   char *quantity);
 
+/**
+ * @brief Initialize continuum coefficients of each channel.
+ *
+ * Interpolates the spectral coefficients of the CO₂, H₂O, N₂, and O₂
+ * continua to the channel wavenumbers once, so that formod_continua()
+ * only needs to evaluate the pressure and temperature dependence.
+ *
+ * @param[in]  ctl  Control structure defining the spectral channels.
+ * @param[out] tbl  Look-up tables receiving the continuum coefficients.
+ *
+ * @see ctmco2_coeff, ctmh2o_coeff, ctmn2_coeff, ctmo2_coeff,
+ *      formod_continua
+ */
+void init_ctm(
+  const ctl_t * ctl,
+  tbl_t * tbl);
+
 /**
  * @brief Initialize the source-function (Planck radiance) lookup table.
  *
@@ -2307,13 +2851,20 @@ void idx2name(
  * the Planck function is integrated over the instrument filter function
  * defined in the corresponding filter file (*.filt).
  *
+ * If `ctl->srccache` is set, the source function of each channel is
+ * cached in `<srccache>/srcfunc_<hash>.bin`, where the hash covers the
+ * filter function and the temperature grid (@ref TMIN, @ref TMAX,
+ * @ref TBLNS). Cached source functions are read instead of being
+ * recomputed (see read_srcfunc() and write_srcfunc()).
+ *
  * @param[in]  ctl  Control structure defining spectral channels and table base name.
  * @param[out] tbl  Emissivity and source-function lookup table to populate.
  *
  * @note The source function is tabulated for @ref TBLNS temperature levels
  *       uniformly distributed between @ref TMIN and @ref TMAX. Integration
  *       over the spectral response is performed using linear interpolation
- *       and uniform grid spacing.
+ *       and uniform grid spacing. The filter weights and Planck factors
+ *       of the fine grid are computed once per channel.
  *
  * @see ctl_t, tbl_t, read_shape, locate_irr, LIN, PLANCK, TBLNS, TMIN, TMAX
  * 
@@ -2331,6 +2882,95 @@ void init_srcfunc(
   const ctl_t * ctl,
   tbl_t * tbl);
 
+/**
+ * @brief Pack the data of an emissivity table block.
+ *
+ * Copies the column densities and emissivities of all tables of the
+ * given channel and emitter from the staging buffers (layout
+ * `[TBLNP][TBLNT][TBLNU]`) into a contiguous block sized to the actual
+ * numbers of pressure levels, temperatures, and column densities, and
+ * sets the offsets and table indices used by @ref TBL_U and @ref TBL_EPS.
+ * If the staging buffers are NULL, only the offsets and table indices
+ * are set and the block pointers are left unchanged.
+ *
+ * @param[in,out] tbl  Emissivity lookup tables.
+ * @param[in]     id   Channel index.
+ * @param[in]     ig   Emitter index.
+ * @param[in]     su   Staging buffer of column densities (or NULL).
+ * @param[in]     seps Staging buffer of emissivities (or NULL).
+ *
+ * @return Number of data points in the table block.
+ *
+ * @see read_tbl, read_tbl_map, TBL_U, TBL_EPS
+ */
+int init_tbl_block(
+  tbl_t * tbl,
+  const int id,
+  const int ig,
+  const float *su,
+  const float *seps);
+
+/**
+ * @brief Group channels with identical table grids.
+ *
+ * For each emitter, compares the pressure and temperature grids of the
+ * emissivity tables of all channels and sets @ref tbl_t::ref to the
+ * first channel with the same grids. Table indices can then be
+ * computed once per group (see @ref intpol_tbl_idx).
+ *
+ * @param[in]     ctl  Control structure (number of channels and gases).
+ * @param[in,out] tbl  Emissivity lookup tables.
+ *
+ * @see intpol_tbl_idx, read_tbl
+ */
+void init_tbl_group(
+  const ctl_t * ctl,
+  tbl_t * tbl);
+
+/**
+ * @brief Initialize guide tables for emissivity table lookups.
+ *
+ * For each emissivity table, the range of column densities is divided
+ * into @ref TBLNB logarithmically spaced bins and the range of
+ * emissivities into @ref TBLNB regular bins. For each bin, the index of
+ * the last grid point below the lower bin edge is stored, so that
+ * @ref locate_tbl_guide() finds the interpolation index with a few
+ * steps instead of a binary search.
+ *
+ * @param[in]     ctl  Control structure (number of channels and gases).
+ * @param[in,out] tbl  Emissivity lookup tables.
+ *
+ * @see intpol_tbl_eps, intpol_tbl_u, locate_tbl_guide, read_tbl
+ */
+void init_tbl_guide(
+  const ctl_t * ctl,
+  tbl_t * tbl);
+
+/**
+ * @brief Quantise emissivity tables to 16-bit integers.
+ *
+ * Converts the packed emissivity table blocks to unsigned 16-bit
+ * integers, halving their memory footprint. Emissivities are scaled
+ * on a logit scale and column densities on a log scale between the
+ * first and last grid point of each table (see @ref TBL_DEQ_EPS and
+ * @ref TBL_DEQ_U), so that the table boundaries are represented exactly.
+ * Quantised values are kept strictly increasing.
+ * The offsets and scaling factors of each table are stored in
+ * @ref tbl_t::uqs and @ref tbl_t::epsqs, and the float blocks are freed.
+ * Dequantisation is done on the fly in intpol_tbl_eps() and
+ * intpol_tbl_u().
+ *
+ * @param[in]     ctl  Control structure (number of channels and gases).
+ * @param[in,out] tbl  Emissivity lookup tables.
+ *
+ * @note Memory-mapped tables (`ctl->tblfmt = 4`) are not quantised.
+ *
+ * @see intpol_tbl_eps, intpol_tbl_u, read_tbl
+ */
+void init_tbl_quant(
+  const ctl_t * ctl,
+  tbl_t * tbl);
+
 /**
  * @brief Interpolate atmospheric state variables at a given altitude.
  *
@@ -2469,14 +3109,16 @@ void intpol_tbl_ega(
  *
  * @details
  * - Performs linear interpolation in column density between adjacent
- *   grid points using @ref LIN.
+ *   grid points using @ref LIN. The grid index is obtained from the
+ *   log-spaced guide table (@ref locate_tbl_guide).
  * - Applies lower-bound extrapolation proportional to `u` for
  *   `u < u_min`.
  * - Applies exponential upper-bound extrapolation ensuring
  *   asymptotic emissivity growth (`eps → 1` as `u → ∞`).
- * - The input arrays are taken from `tbl->u` and `tbl->eps`.
+ * - The input arrays are taken from `tbl->u` and `tbl->eps`, or from the
+ *   quantised tables via intpol_tbl_eps_q() if `tbl->quant` is set.
  *
- * @see tbl_t, LIN, locate_tbl
+ * @see tbl_t, LIN, locate_tbl_guide
  *
  * @note Used by both the Curtis–Godson (CGA) and Emissivity Growth
  *       Approximation (EGA) interpolation schemes.
@@ -2491,6 +3133,127 @@ double intpol_tbl_eps(
   const int it,
   const double u);
 
+/**
+ * @brief Interpolate emissivity in a quantised emissivity table.
+ *
+ * Same as intpol_tbl_eps(), but for quantised tables (see init_tbl_quant()).
+ * The quantised data of the two neighbouring grid points are converted
+ * back to physical units on the fly before the interpolation.
+ *
+ * @param[in] tbl  Emissivity lookup tables (quantised).
+ * @param[in] ig   Emitter index.
+ * @param[in] id   Channel index.
+ * @param[in] ip   Pressure level index.
+ * @param[in] it   Temperature index.
+ * @param[in] u    Column density [molecules/cm^2].
+ *
+ * @return Interpolated emissivity.
+ *
+ * @see intpol_tbl_eps, init_tbl_quant, locate_tbl_guide_q
+ */
+double intpol_tbl_eps_q(
+  const tbl_t * tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double u);
+
+/**
+ * @brief Interpolate emissivity and its column density derivative.
+ *
+ * Same as intpol_tbl_eps or intpol_tbl_eps_q (depending on
+ * @ref tbl_t::quant), but also returns the slope of the interpolation
+ * or extrapolation used at the given column density.
+ *
+ * @param[in]  tbl   Emissivity lookup tables.
+ * @param[in]  ig    Emitter index.
+ * @param[in]  id    Channel index.
+ * @param[in]  ip    Pressure level index.
+ * @param[in]  it    Temperature index.
+ * @param[in]  u     Column density [molecules/cm^2].
+ * @param[out] deps  Derivative of emissivity with respect to `u`.
+ *
+ * @return Interpolated emissivity.
+ *
+ * @see intpol_tbl_eps, intpol_tbl_tl
+ */
+double intpol_tbl_eps_tl(
+  const tbl_t * tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double u,
+  double *deps);
+
+/**
+ * @brief Determine pressure and temperature indices of emissivity tables.
+ *
+ * Locates the pressure index and the temperature indices at the two
+ * enclosing pressure levels for all channels and emitters. The search
+ * is done only once for each group of channels sharing the same grids
+ * (@ref tbl_t::ref); the other channels copy the indices.
+ *
+ * @param[in]  ctl  Control structure (number of channels and gases).
+ * @param[in]  tbl  Emissivity lookup tables.
+ * @param[in]  p    Pressure of each emitter [hPa].
+ * @param[in]  t    Temperature of each emitter [K].
+ * @param[out] ipr  Pressure index.
+ * @param[out] it0  Temperature index at pressure level `ipr`.
+ * @param[out] it1  Temperature index at pressure level `ipr + 1`.
+ *
+ * @note Indices are only set for tables with at least 30 pressure levels.
+ *
+ * @see intpol_tbl_cga, intpol_tbl_ega, init_tbl_group
+ */
+void intpol_tbl_idx(
+  const ctl_t * ctl,
+  const tbl_t * tbl,
+  const double *p,
+  const double *t,
+  int ipr[ND][NG],
+  int it0[ND][NG],
+  int it1[ND][NG]);
+
+/**
+ * @brief Tangent-linear emissivity table lookup for one channel.
+ *
+ * Performs the EGA or CGA table interpolation of intpol_tbl_ega and
+ * intpol_tbl_cga for a single channel and LOS point, and returns the
+ * partial derivatives of the updated path transmittance of each
+ * emitter.
+ *
+ * @param[in]     ctl       Control structure (forward model, emitters).
+ * @param[in]     tbl       Emissivity lookup tables.
+ * @param[in]     los       Line-of-sight data.
+ * @param[in]     ip        LOS point index.
+ * @param[in]     id        Channel index.
+ * @param[in,out] tau_path  Path transmittance of each emitter.
+ * @param[out]    tau_seg   Gas transmittance of the segment.
+ * @param[out]    dtau      Derivatives of the updated path transmittance
+ *                          of emitter `ig` in `dtau[4*ig..4*ig+3]`.
+ *
+ * @details
+ * The four derivatives of each emitter are taken with respect to
+ * pressure, temperature, column density, and the incoming path
+ * transmittance. For EGA these refer to the local values at the LOS
+ * point, for CGA to the Curtis-Godson means (the incoming path
+ * transmittance is then not used). Derivatives are set to zero where
+ * the emissivity is clipped to [0, 1] or the path is saturated.
+ *
+ * @see intpol_tbl_cga, intpol_tbl_ega, kernel_analytic
+ */
+void intpol_tbl_tl(
+  const ctl_t * ctl,
+  const tbl_t * tbl,
+  const los_t * los,
+  const int ip,
+  const int id,
+  double *tau_path,
+  double *tau_seg,
+  double *dtau);
+
 /**
  * @brief Interpolate column density from lookup tables as a function
  *        of emissivity.
@@ -2509,14 +3272,16 @@ double intpol_tbl_eps(
  *
  * @details
  * - Performs linear interpolation in emissivity between adjacent
- *   table entries using @ref LIN.
+ *   table entries using @ref LIN. The grid index is obtained from the
+ *   regular emissivity guide table (@ref locate_tbl_guide).
  * - For `eps < eps_min`, applies linear extrapolation proportional
  *   to emissivity.
  * - For `eps > eps_max`, applies exponential extrapolation
  *   following the emissivity growth law.
- * - The lookup is performed using `tbl->eps` and `tbl->u`.
+ * - The lookup is performed using `tbl->eps` and `tbl->u`, or using the
+ *   quantised tables via intpol_tbl_u_q() if `tbl->quant` is set.
  *
- * @see tbl_t, LIN, locate_tbl
+ * @see tbl_t, LIN, locate_tbl_guide
  *
  * @note Used in the Emissivity Growth Approximation (EGA) to
  *       determine effective column density from transmittance.
@@ -2531,6 +3296,60 @@ double intpol_tbl_u(
   const int it,
   const double eps);
 
+/**
+ * @brief Interpolate column density in a quantised emissivity table.
+ *
+ * Same as intpol_tbl_u(), but for quantised tables (see init_tbl_quant()).
+ * The quantised data of the two neighbouring grid points are converted
+ * back to physical units on the fly before the interpolation.
+ *
+ * @param[in] tbl  Emissivity lookup tables (quantised).
+ * @param[in] ig   Emitter index.
+ * @param[in] id   Channel index.
+ * @param[in] ip   Pressure level index.
+ * @param[in] it   Temperature index.
+ * @param[in] eps  Emissivity [-].
+ *
+ * @return Interpolated column density [molecules/cm^2].
+ *
+ * @see intpol_tbl_u, init_tbl_quant, locate_tbl_guide_q
+ */
+double intpol_tbl_u_q(
+  const tbl_t * tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double eps);
+
+/**
+ * @brief Interpolate column density and its emissivity derivative.
+ *
+ * Same as intpol_tbl_u or intpol_tbl_u_q (depending on
+ * @ref tbl_t::quant), but also returns the slope of the interpolation
+ * or extrapolation used at the given emissivity.
+ *
+ * @param[in]  tbl  Emissivity lookup tables.
+ * @param[in]  ig   Emitter index.
+ * @param[in]  id   Channel index.
+ * @param[in]  ip   Pressure level index.
+ * @param[in]  it   Temperature index.
+ * @param[in]  eps  Emissivity.
+ * @param[out] du   Derivative of column density with respect to `eps`.
+ *
+ * @return Interpolated column density [molecules/cm^2].
+ *
+ * @see intpol_tbl_u, intpol_tbl_tl
+ */
+double intpol_tbl_u_tl(
+  const tbl_t * tbl,
+  const int ig,
+  const int id,
+  const int ip,
+  const int it,
+  const double eps,
+  double *du);
+
 /**
  * @brief Converts Julian seconds to calendar date and time components.
  *
@@ -2589,8 +3408,13 @@ void jsec2time(
  *   reference measurement vector.
  * - Each state vector element is perturbed by an adaptive step `h`
  *   depending on its physical type (pressure, temperature, VMR, etc.).
- * - For each perturbation, the forward model is re-evaluated, and
+ * - Extinction and surface columns, and without refraction also the
+ *   pressure, temperature, and VMR columns, are computed analytically
+ *   in a single pass where possible (see kernel_analytic).
+ * - For all other elements, the forward model is re-evaluated, and
  *   the corresponding column of *K* is estimated using finite differences.
+ * - Without refraction, the LOS geometry is traced only once and reused
+ *   for all columns (see formod_geo).
  * - Parallelized over state vector elements using OpenMP.
  *
  * @note
@@ -2615,6 +3439,69 @@ void kernel(
   obs_t * obs,
   gsl_matrix * k);
 
+/**
+ * @brief Compute analytic Jacobian columns.
+ *
+ * Computes the derivatives of the EGA/CGA radiances with respect to
+ * the aerosol/cloud extinction profiles, the surface temperature, and
+ * the surface emissivities, and, without refraction, with respect to
+ * the pressure, temperature, and volume mixing ratio profiles in a
+ * single pass over each ray path.
+ *
+ * @param[in]  ctl   Control structure defining retrieval configuration.
+ * @param[in]  tbl   Emissivity lookup tables used by the forward model.
+ * @param[in]  atm   Atmospheric data (after hydrostatic adjustment).
+ * @param[in]  obs   Observation geometry and radiance data.
+ * @param[in]  iqa   Quantity index of each state vector element.
+ * @param[in]  ipa   Profile index of each state vector element.
+ * @param[out] k     Jacobian matrix [m×n].
+ * @param[out] done  Flags of state vector elements that were computed.
+ *
+ * @details
+ * With the segment emissivity
+ * \f$ \varepsilon_i = 1 - \tau_{g,i} \exp(-\beta_i \Delta s_i) \f$,
+ * the derivative of the radiance with respect to the extinction
+ * coefficient of segment *i* is
+ * \f[
+ *   \frac{\partial R}{\partial \beta_i} = \Delta s_i \left[
+ *   (1 - \varepsilon_i) B_i \mathcal{T}_i - R_{>i} \right],
+ * \f]
+ * where \f$ \mathcal{T}_i \f$ is the path transmittance in front of
+ * the segment and \f$ R_{>i} \f$ the radiance contribution from
+ * behind the segment, including surface emission.
+ *
+ * Pressure, temperature, and VMR enter through the source function,
+ * the continua (formod_continua_tl), the column densities, and the
+ * emissivity table lookups (intpol_tbl_tl). The table derivatives are
+ * propagated backward along the ray, through the EGA recursion of the
+ * path transmittance or the Curtis-Godson means, respectively. The
+ * source function derivative is the slope of its tabulated
+ * interpolation. Pressure changes due to hydrostatic equilibrium
+ * (`HYDZ`) are included by finite differences of hydrostatic, which
+ * do not require additional forward model runs.
+ *
+ * The chain rule is finally applied to the interpolation of the
+ * profiles onto the LOS points, the spectral interpolation of the
+ * surface emissivity, and the conversion to brightness temperature.
+ *
+ * Nothing is done for the RFM forward model, for field-of-view
+ * convolution, and for reflecting surfaces (`sftype >= 2` with a
+ * surface emissivity below one in any channel). With
+ * refraction, the pressure, temperature, and VMR columns change the
+ * ray geometry and are left to finite differences.
+ *
+ * @see kernel, formod_pencil, raytrace
+ */
+void kernel_analytic(
+  const ctl_t * ctl,
+  const tbl_t * tbl,
+  const atm_t * atm,
+  obs_t * obs,
+  const int *iqa,
+  const int *ipa,
+  gsl_matrix * k,
+  int *done);
+
 /**
  * @brief Locate index for interpolation on an irregular grid.
  *
@@ -2707,6 +3594,52 @@ int locate_tbl(
   const int n,
   const double x);
 
+/**
+ * @brief Locate index within emissivity table grids using a guide table.
+ *
+ * Returns the same index as @ref locate_tbl, starting from the guide
+ * table entry of the given bin and stepping to the neighbouring grid
+ * points until \f$ xx[i] \le x < xx[i+1] \f$.
+ *
+ * @param[in] xx  Monotonic (increasing) single-precision grid array.
+ * @param[in] n   Number of grid points.
+ * @param[in] x   Target value to locate within the grid range.
+ * @param[in] gd  Guide table of the grid (see @ref init_tbl_guide).
+ * @param[in] ib  Guide table bin of `x`.
+ * @return Index `ilo` of the lower grid point surrounding `x`.
+ *
+ * @see locate_tbl, init_tbl_guide, intpol_tbl_eps, intpol_tbl_u
+ */
+int locate_tbl_guide(
+  const float *xx,
+  const int n,
+  const double x,
+  const unsigned short *gd,
+  const int ib);
+
+/**
+ * @brief Find interpolation index in a quantised emissivity table.
+ *
+ * Same as locate_tbl_guide(), but for quantised table data
+ * (see init_tbl_quant()). The search value is given in quantised units.
+ *
+ * @param[in] xx  Quantised table data (strictly increasing).
+ * @param[in] n   Number of data points.
+ * @param[in] x   Search value (quantised units).
+ * @param[in] gd  Guide table of the table (@ref TBLNB entries).
+ * @param[in] ib  Guide table bin of the search value.
+ *
+ * @return Index `i` with `xx[i] <= x < xx[i + 1]`, clamped to `[0, n - 2]`.
+ *
+ * @see locate_tbl_guide, init_tbl_quant
+ */
+int locate_tbl_guide_q(
+  const unsigned short *xx,
+  const int n,
+  const double x,
+  const unsigned short *gd,
+  const int ib);
+
 /*!
  * @brief Invert a square matrix, optimized for diagonal or symmetric positive-definite matrices.
  *
@@ -2892,6 +3825,40 @@ void optimal_estimation(
   atm_t * atm_i,
   double *chisq);
 
+/**
+ * @brief Optimal estimation retrieval with optional warm start.
+ *
+ * Same as optimal_estimation(), but the iteration can start from the
+ * state vector and kernel matrix of a previous (neighbouring)
+ * retrieval. The warm start is only used if the problem dimensions
+ * match and if its cost function is lower than that of the a priori
+ * state; otherwise the retrieval starts from the a priori state. On
+ * return, the warm-start data are replaced by the current result if
+ * the retrieval converged, and are left unchanged otherwise.
+ *
+ * @param[out]    ret       Retrieval configuration (see optimal_estimation()).
+ * @param[in]     ctl       Control parameters.
+ * @param[in]     tbl       Lookup tables required by the forward model.
+ * @param[in]     obs_meas  Measured observations used as input.
+ * @param[out]    obs_i     Modeled observations of the retrieved state.
+ * @param[in]     atm_apr   A priori atmospheric state.
+ * @param[out]    atm_i     Retrieved atmospheric state.
+ * @param[out]    chisq     Final value of the cost function.
+ * @param[in,out] warm      Warm-start data (NULL to disable).
+ *
+ * @see optimal_estimation()
+ */
+void optimal_estimation_warm(
+  ret_t * ret,
+  ctl_t * ctl,
+  tbl_t * tbl,
+  obs_t * obs_meas,
+  obs_t * obs_i,
+  atm_t * atm_apr,
+  atm_t * atm_i,
+  double *chisq,
+  warm_t * warm);
+
 /**
  * @brief Perform line-of-sight (LOS) ray tracing through the atmosphere.
  *
@@ -2937,6 +3904,43 @@ void raytrace(
   los_t * los,
   const int ir);
 
+/**
+ * @brief Compute column densities and Curtis–Godson means along the LOS.
+ *
+ * @param[in]     ctl  Control structure (number of emitters).
+ * @param[in,out] los  Line-of-sight data with pressure, temperature,
+ *                     volume mixing ratios, and segment lengths.
+ *
+ * @see raytrace, raytrace_geo
+ */
+void raytrace_cgm(
+  const ctl_t * ctl,
+  los_t * los);
+
+/**
+ * @brief Sample atmospheric data along a precomputed LOS geometry.
+ *
+ * Fills the LOS structure like @ref raytrace(), but takes the ray path
+ * from @p geo instead of tracing it. Only the atmospheric data,
+ * extinction, surface data, column densities, and Curtis–Godson means
+ * are recomputed.
+ *
+ * @param[in]  ctl  Control structure.
+ * @param[in]  atm  Atmospheric data.
+ * @param[in]  geo  LOS geometry (from a previous call of @ref raytrace()).
+ * @param[out] los  Line-of-sight data.
+ *
+ * @note Valid only without refraction, since the ray path is then
+ *       independent of the atmospheric state.
+ *
+ * @see raytrace, raytrace_cgm, formod_geo, kernel
+ */
+void raytrace_geo(
+  const ctl_t * ctl,
+  const atm_t * atm,
+  const geo_t * geo,
+  los_t * los);
+
 /**
  * @brief Read atmospheric input data from a file.
  *
@@ -3493,6 +4497,26 @@ void read_shape(
   double *y,
   int *n);
 
+/**
+ * @brief Read a cached source function table.
+ *
+ * Reads the source function of one channel from a cache file written
+ * by write_srcfunc() and checks that it matches the given hash and the
+ * temperature grid (@ref TMIN, @ref TMAX, @ref TBLNS).
+ *
+ * @param[in]  filename  Name of the cache file.
+ * @param[in]  hash      Hash of the filter function and temperature grid.
+ * @param[out] sr        Source function [W/(m^2 sr cm^-1)] (@ref TBLNS values).
+ *
+ * @return 0 on success, -1 if the file is missing or does not match.
+ *
+ * @see init_srcfunc, write_srcfunc
+ */
+int read_srcfunc(
+  const char *filename,
+  const uint64_t hash,
+  double *sr);
+
 /**
  * @brief Read all emissivity lookup tables for all gases and frequencies.
  *
@@ -3500,6 +4524,8 @@ void read_shape(
  * emissivity lookup tables for each trace gas (`ig`) and each frequency index
  * (`id`) specified in the control structure. The lookup tables may be read
  * from ASCII, binary, or per-gas table files depending on `ctl->tblfmt`.
+ * Memory-mapped table files (`ctl->tblfmt = 4`) are mapped read-only
+ * and shared with all other processes on the node (see read_tbl_map()).
  *
  * After loading all tables, the source function is initialized with
  * `init_srcfunc()`.
@@ -3581,11 +4607,14 @@ void read_tbl_bin(
 /**
  * @brief Read one frequency block from a per-gas binary table file.
  *
- * Opens the gas-specific table file (e.g., `base_emitter.tbl`) and
- * reads the table block corresponding to frequency `ctl->nu[id]`.
- * The block is appended to the in-memory `tbl_t`.
+ * Reads the table block corresponding to frequency `ctl->nu[id]` from
+ * the gas-specific table file (e.g., `base_emitter.tbl`), which has been
+ * opened once per gas by read_tbl(). The block is appended to the
+ * in-memory `tbl_t`. Different channels may be read in parallel.
  *
  * @param ctl  Pointer to control structure containing table metadata.
+ * @param g    Pointer to the open gas-table handle (fp is NULL if the
+ *             file is missing).
  * @param tbl  Pointer to table structure to populate.
  * @param id   Frequency index.
  * @param ig   Gas index.
@@ -3596,6 +4625,7 @@ void read_tbl_bin(
  */
 void read_tbl_gas(
   const ctl_t * ctl,
+  const tbl_gas_t * g,
   tbl_t * tbl,
   const int id,
   const int ig);
@@ -3620,7 +4650,8 @@ int read_tbl_gas_close(
  * @brief Open a per-gas binary table file for reading and writing.
  *
  * Reads and validates the file header, then loads the entire index
- * of table blocks. The resulting `tbl_gas_t` structure tracks the
+ * of table blocks and sorts the entries in use by frequency for
+ * binary search. The resulting `tbl_gas_t` structure tracks the
  * file pointer, index, and table count.
  *
  * @param path  Path to the `.tbl` file.
@@ -3639,8 +4670,9 @@ int read_tbl_gas_open(
 /**
  * @brief Read one emissivity table block from a per-gas table file.
  *
- * Locates the index entry corresponding to the requested frequency @p freq.
- * If found, seeks to the stored offset and reads:
+ * Locates the index entry corresponding to the requested frequency @p freq
+ * by binary search in the sorted index. If found, the whole block is
+ * read with a single positioned read (thread-safe) and parsed in memory:
  *
  *   - number of pressure levels
  *   - pressure grid
@@ -3662,7 +4694,7 @@ int read_tbl_gas_open(
  *
  * @return 0 on success, -1 if the frequency is not found.
  *
- * @warning Aborts on dimension overflow or seek errors.
+ * @warning Aborts on dimension overflow or read errors.
  *
  * @author Lars Hoffmann
  */
@@ -3673,6 +4705,55 @@ int read_tbl_gas_single(
   const int id,
   const int ig);
 
+/**
+ * @brief Map one frequency block of a memory-mapped table file.
+ *
+ * The table block of frequency `ctl->nu[id]` is located by a binary
+ * search in the sorted index of the file mapped by read_tbl_map_open().
+ * The pressure and temperature grids are copied to `tbl`, while the
+ * column densities and emissivities are accessed directly in the
+ * mapped file. Nothing is done if the file of the emitter is missing.
+ *
+ * @param ctl  Pointer to control structure containing table metadata.
+ * @param tbl  Pointer to table structure to populate.
+ * @param id   Frequency index.
+ * @param ig   Gas index.
+ *
+ * @note Missing frequency blocks only produce warnings.
+ *
+ * @warning Aborts via ERRMSG() if the table block is corrupt.
+ *
+ * @see read_tbl_map_open, write_tbl_map, tbl_map_hdr_t, tbl_map_block_t
+ */
+void read_tbl_map(
+  const ctl_t * ctl,
+  tbl_t * tbl,
+  const int id,
+  const int ig);
+
+/**
+ * @brief Map a memory-mapped table file of one emitter.
+ *
+ * Maps the table file `<base>_<emitter>.map` read-only into memory
+ * with a shared file mapping, so that all processes on a node share a
+ * single physical copy via the page cache, and checks its header.
+ *
+ * @param filename  Path to the `.map` file.
+ * @param tbl       Table structure receiving the mapping.
+ * @param ig        Gas index.
+ *
+ * @return 0 on success, -1 if the file cannot be opened.
+ *
+ * @warning Aborts via ERRMSG() if the file is corrupt or was written
+ *          with different table dimensions (TBLNP, TBLNT).
+ *
+ * @see read_tbl_map, write_tbl_map
+ */
+int read_tbl_map_open(
+  const char *filename,
+  tbl_t * tbl,
+  const int ig);
+
 /**
  * @brief Scan control file or command-line arguments for a configuration variable.
  *
@@ -4456,6 +5537,26 @@ void write_shape(
   const double *y,
   const int n);
 
+/**
+ * @brief Write a source function table to the cache.
+ *
+ * Writes the source function of one channel together with its hash and
+ * the temperature grid to a temporary file, which is then renamed to the
+ * cache file, so that concurrent processes never read partial files.
+ *
+ * @param[in] filename  Name of the cache file.
+ * @param[in] hash      Hash of the filter function and temperature grid.
+ * @param[in] sr        Source function [W/(m^2 sr cm^-1)] (@ref TBLNS values).
+ *
+ * @note Failures to create the cache file only produce warnings.
+ *
+ * @see init_srcfunc, read_srcfunc
+ */
+void write_srcfunc(
+  const char *filename,
+  const uint64_t hash,
+  const double *sr);
+
 /**
  * @brief Write retrieval standard deviation profiles to disk.
  *
@@ -4511,12 +5612,13 @@ void write_stddev(
 /**
  * @brief Write all emissivity lookup tables in the format specified by the control structure.
  *
- * This function dispatches to one of three table writers depending on
+ * This function dispatches to one of four table writers depending on
  * `ctl->tblfmt`:
  *
  *   - `1`: ASCII tables written by write_tbl_asc()
  *   - `2`: Binary tables written by write_tbl_bin()
  *   - `3`: Per-gas binary tables written by write_tbl_gas()
+ *   - `4`: Per-gas memory-mapped tables written by write_tbl_map()
  *
  * If an unknown format is given, the function aborts via ERRMSG().
  *
@@ -4679,6 +5781,29 @@ int write_tbl_gas_single(
   const int id,
   const int ig);
 
+/**
+ * @brief Write lookup tables into per-gas memory-mapped table files.
+ *
+ * Creates one file per emitter of the form `<base>_<emitter>.map`,
+ * containing a header (@ref tbl_map_hdr_t), an index of all channels
+ * sorted by frequency (@ref tbl_gas_index_t), and one table block per
+ * channel (@ref tbl_map_block_t) with the packed column densities and
+ * emissivities. All parts are aligned to @ref TBLALIGN bytes, so that
+ * the file can be used directly via read_tbl_map().
+ *
+ * @param ctl  Control structure specifying table base name, emitters,
+ *             and channels.
+ * @param tbl  Fully populated lookup-table structure to be written.
+ *
+ * @warning Aborts via ERRMSG() on duplicate channel frequencies or
+ *          file errors.
+ *
+ * @see read_tbl_map
+ */
+void write_tbl_map(
+  const ctl_t * ctl,
+  const tbl_t * tbl);
+
 /**
  * @brief Map retrieval state vector back to atmospheric structure.
  *
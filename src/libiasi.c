@@ -806,6 +806,215 @@ void iasi_read_netcdf(
 
 /*****************************************************************************/
 
+static void kdtree_select(
+  kdtree_t *kd,
+  int lo,
+  int hi,
+  int k,
+  int a) {
+
+  /* Partially sort indices so that element k is in place (quickselect)... */
+  while (hi > lo) {
+    const double piv = kd->x[kd->idx[(lo + hi) / 2]][a];
+    int i = lo, j = hi;
+    while (i <= j) {
+      while (kd->x[kd->idx[i]][a] < piv)
+	i++;
+      while (kd->x[kd->idx[j]][a] > piv)
+	j--;
+      if (i <= j) {
+	const int help = kd->idx[i];
+	kd->idx[i] = kd->idx[j];
+	kd->idx[j] = help;
+	i++;
+	j--;
+      }
+    }
+    if (k <= j)
+      hi = j;
+    else if (k >= i)
+      lo = i;
+    else
+      return;
+  }
+}
+
+static void kdtree_build_help(
+  kdtree_t *kd,
+  int lo,
+  int hi) {
+
+  double xmin[3], xmax[3];
+
+  int a = 0;
+
+  /* Check size... */
+  if (hi - lo < 2)
+    return;
+
+  /* Split along axis of largest extent... */
+  for (int i = 0; i < 3; i++)
+    xmin[i] = xmax[i] = kd->x[kd->idx[lo]][i];
+  for (int k = lo + 1; k < hi; k++)
+    for (int i = 0; i < 3; i++) {
+      xmin[i] = GSL_MIN(xmin[i], kd->x[kd->idx[k]][i]);
+      xmax[i] = GSL_MAX(xmax[i], kd->x[kd->idx[k]][i]);
+    }
+  for (int i = 1; i < 3; i++)
+    if (xmax[i] - xmin[i] > xmax[a] - xmin[a])
+      a = i;
+
+  /* Put median in place and build subtrees... */
+  const int mid = (lo + hi) / 2;
+  kdtree_select(kd, lo, hi - 1, mid, a);
+  kd->axis[mid] = a;
+  kdtree_build_help(kd, lo, mid);
+  kdtree_build_help(kd, mid + 1, hi);
+}
+
+void kdtree_build(
+  kdtree_t *kd,
+  const double *lon,
+  const double *lat,
+  int n) {
+
+  /* Allocate... */
+  ALLOC(kd->x, double[3], n);
+  ALLOC(kd->idx, int, n);
+  ALLOC(kd->axis, int, n);
+
+  /* Get Cartesian coordinates of valid footprints... */
+  kd->n = 0;
+  for (int i = 0; i < n; i++)
+    if (gsl_finite(lon[i]) && gsl_finite(lat[i])) {
+      geo2cart(0, lon[i], lat[i], kd->x[i]);
+      kd->idx[kd->n++] = i;
+    }
+
+  /* Build tree... */
+  kdtree_build_help(kd, 0, kd->n);
+}
+
+/*****************************************************************************/
+
+void kdtree_free(
+  kdtree_t *kd) {
+
+  free(kd->x);
+  free(kd->idx);
+  free(kd->axis);
+  kd->n = 0;
+}
+
+/*****************************************************************************/
+
+static void kdtree_nearest_help(
+  const kdtree_t *kd,
+  int lo,
+  int hi,
+  const double *x0,
+  int *imin,
+  double *dmin) {
+
+  /* Check size... */
+  if (hi <= lo)
+    return;
+
+  /* Check node... */
+  const int mid = (lo + hi) / 2, i = kd->idx[mid], a = kd->axis[mid];
+  const double d2 = DIST2(x0, kd->x[i]);
+  if (d2 < *dmin) {
+    *dmin = d2;
+    *imin = i;
+  }
+
+  /* Search near side first, far side only if it can be closer... */
+  const double dx = x0[a] - kd->x[i][a];
+  if (dx < 0) {
+    kdtree_nearest_help(kd, lo, mid, x0, imin, dmin);
+    if (dx * dx < *dmin)
+      kdtree_nearest_help(kd, mid + 1, hi, x0, imin, dmin);
+  } else {
+    kdtree_nearest_help(kd, mid + 1, hi, x0, imin, dmin);
+    if (dx * dx < *dmin)
+      kdtree_nearest_help(kd, lo, mid, x0, imin, dmin);
+  }
+}
+
+int kdtree_nearest(
+  const kdtree_t *kd,
+  double lon,
+  double lat,
+  double *dist) {
+
+  double dmin = 1e100, x0[3];
+
+  int imin = -1;
+
+  /* Search tree... */
+  geo2cart(0, lon, lat, x0);
+  kdtree_nearest_help(kd, 0, kd->n, x0, &imin, &dmin);
+
+  /* Return distance [km]... */
+  if (dist != NULL)
+    *dist = (imin >= 0 ? sqrt(dmin) : GSL_NAN);
+
+  return imin;
+}
+
+/*****************************************************************************/
+
+static void kdtree_radius_help(
+  const kdtree_t *kd,
+  int lo,
+  int hi,
+  const double *x0,
+  double r2,
+  int *list,
+  int nmax,
+  int *n) {
+
+  /* Check size... */
+  if (hi <= lo)
+    return;
+
+  /* Check node... */
+  const int mid = (lo + hi) / 2, i = kd->idx[mid], a = kd->axis[mid];
+  if (DIST2(x0, kd->x[i]) <= r2) {
+    if (*n >= nmax)
+      ERRMSG("Too many footprints within search radius!");
+    list[(*n)++] = i;
+  }
+
+  /* Search subtrees that overlap the search sphere... */
+  const double dx = x0[a] - kd->x[i][a];
+  if (dx <= 0 || dx * dx <= r2)
+    kdtree_radius_help(kd, lo, mid, x0, r2, list, nmax, n);
+  if (dx >= 0 || dx * dx <= r2)
+    kdtree_radius_help(kd, mid + 1, hi, x0, r2, list, nmax, n);
+}
+
+int kdtree_radius(
+  const kdtree_t *kd,
+  double lon,
+  double lat,
+  double r,
+  int *list,
+  int nmax) {
+
+  double x0[3];
+
+  int n = 0;
+
+  /* Search tree... */
+  geo2cart(0, lon, lat, x0);
+  kdtree_radius_help(kd, 0, kd->n, x0, r * r, list, nmax, &n);
+
+  return n;
+}
+
+/*****************************************************************************/
+
 void median(
   wave_t *wave,
   int dx) {
@@ -890,6 +1099,106 @@ void noise(
 
 /*****************************************************************************/
 
+void noise_chan(
+  iasi_rad_t *iasi_rad,
+  int track0,
+  int track1,
+  double *mu,
+  double *sig) {
+
+  double (*bt)[L1_NXTRACK][IASI_L1_NCHAN], *c1, *c2;
+
+  int *n;
+
+  /* Allocate (ring buffer of three tracks)... */
+  ALLOC(bt, double[L1_NXTRACK][IASI_L1_NCHAN], 3);
+  ALLOC(c1, double, IASI_L1_NCHAN);
+  ALLOC(c2, double, IASI_L1_NCHAN);
+  ALLOC(n, int, IASI_L1_NCHAN);
+
+  /* Get coefficients for brightness temperature conversion... */
+  for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++) {
+    c1[ichan] = C1 * POW3(iasi_rad->freq[ichan]);
+    c2[ichan] = C2 * iasi_rad->freq[ichan];
+  }
+
+  /* Init... */
+  for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++)
+    mu[ichan] = sig[ichan] = 0;
+
+  /* Loop over tracks... */
+  for (int iy = track0; iy < track1; iy++) {
+
+    /* Get brightness temperatures of current track... */
+    double (*b2)[IASI_L1_NCHAN] = bt[(iy - track0) % 3];
+    for (int ix = 0; ix < L1_NXTRACK; ix++)
+      for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++)
+	b2[ix][ichan] =
+	  c2[ichan] / log1p(c1[ichan] / iasi_rad->Rad[iy][ix][ichan]);
+
+    /* Check number of tracks... */
+    if (iy - track0 < 2)
+      continue;
+
+    /* Estimate noise of previous track (Immerkaer, 1996)... */
+    double (*b0)[IASI_L1_NCHAN] = bt[(iy - track0 - 2) % 3];
+    double (*b1)[IASI_L1_NCHAN] = bt[(iy - track0 - 1) % 3];
+    for (int ix = 1; ix < L1_NXTRACK - 1; ix++)
+      for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++) {
+
+	/* Apply stencil... */
+	const double d = +4. / 6. * b1[ix][ichan]
+	  - 2. / 6. * (b1[ix - 1][ichan] + b1[ix + 1][ichan]
+		       + b0[ix][ichan] + b2[ix][ichan])
+	  + 1. / 6. * (b0[ix - 1][ichan] + b0[ix + 1][ichan]
+		       + b2[ix - 1][ichan] + b2[ix + 1][ichan]);
+
+	/* Skip stencils with missing data (d is not finite then)... */
+	const int okay = (fabs(d) <= GSL_DBL_MAX);
+	n[ichan] += okay;
+	mu[ichan] += (okay ? b1[ix][ichan] : 0.0);
+	sig[ichan] += (okay ? d * d : 0.0);
+      }
+  }
+
+  /* Normalize... */
+  for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++) {
+    mu[ichan] /= (double) n[ichan];
+    sig[ichan] = sqrt(sig[ichan] / (double) n[ichan]);
+  }
+
+  /* Free... */
+  free(bt);
+  free(c1);
+  free(c2);
+  free(n);
+}
+
+/*****************************************************************************/
+
+void pert2cart(
+  pert_t *pert) {
+
+  /* Allocate... */
+  if (pert->cart == NULL)
+    ALLOC(pert->cart, double[PERT_NXTRACK][3], PERT_NTRACK);
+
+  /* Get Cartesian coordinates... */
+#pragma omp parallel for default(none) shared(pert)
+  for (int itrack = 0; itrack < pert->ntrack; itrack++)
+    for (int ixtrack = 0; ixtrack < pert->nxtrack; ixtrack++) {
+      const double lon = pert->lon[itrack][ixtrack];
+      const double lat = pert->lat[itrack][ixtrack];
+      if (gsl_finite(lon) && gsl_finite(lat))
+	geo2cart(0, lon, lat, pert->cart[itrack][ixtrack]);
+      else
+	for (int i = 0; i < 3; i++)
+	  pert->cart[itrack][ixtrack][i] = GSL_NAN;
+    }
+}
+
+/*****************************************************************************/
+
 void pert2wave(
   pert_t *pert,
   wave_t *wave,
@@ -898,8 +1207,6 @@ void pert2wave(
   int xtrack0,
   int xtrack1) {
 
-  double x0[3], x1[3];
-
   int itrack, ixtrack;
 
   /* Check ranges... */
@@ -916,6 +1223,10 @@ void pert2wave(
   if (wave->ny > WY)
     ERRMSG("Too many along-track values!");
 
+  /* Get Cartesian coordinates... */
+  if (pert->cart == NULL)
+    pert2cart(pert);
+
   /* ------------------------------------------------------------------------- */
   /* Compute wave->x[] and wave->y[] as mean step sizes over the whole window, */
   /* ignoring any lon/lat pairs that contain NaNs (or non-finite values).      */
@@ -930,17 +1241,12 @@ void pert2wave(
     /* mean distance between columns (ixtrack-1) and (ixtrack), averaged over all rows */
     for (itrack = track0; itrack <= track1; itrack++) {
 
-      double lon0 = pert->lon[itrack][ixtrack - 1];
-      double lat0 = pert->lat[itrack][ixtrack - 1];
-      double lon1 = pert->lon[itrack][ixtrack];
-      double lat1 = pert->lat[itrack][ixtrack];
+      const double *x0 = pert->cart[itrack][ixtrack - 1];
+      const double *x1 = pert->cart[itrack][ixtrack];
 
-      if (!isfinite(lon0) || !isfinite(lat0) || !isfinite(lon1)
-	  || !isfinite(lat1))
+      if (!isfinite(x0[0]) || !isfinite(x1[0]))
 	continue;
 
-      geo2cart(0, lon0, lat0, x0);
-      geo2cart(0, lon1, lat1, x1);
       sum += DIST(x0, x1);
       n++;
     }
@@ -959,17 +1265,12 @@ void pert2wave(
     /* mean distance between rows (itrack-1) and (itrack), averaged over all columns */
     for (ixtrack = xtrack0; ixtrack <= xtrack1; ixtrack++) {
 
-      double lon0 = pert->lon[itrack - 1][ixtrack];
-      double lat0 = pert->lat[itrack - 1][ixtrack];
-      double lon1 = pert->lon[itrack][ixtrack];
-      double lat1 = pert->lat[itrack][ixtrack];
+      const double *x0 = pert->cart[itrack - 1][ixtrack];
+      const double *x1 = pert->cart[itrack][ixtrack];
 
-      if (!isfinite(lon0) || !isfinite(lat0) || !isfinite(lon1)
-	  || !isfinite(lat1))
+      if (!isfinite(x0[0]) || !isfinite(x1[0]))
 	continue;
 
-      geo2cart(0, lon0, lat0, x0);
-      geo2cart(0, lon1, lat1, x1);
       sum += DIST(x0, x1);
       n++;
     }
@@ -1082,6 +1383,10 @@ void read_pert(
 
   /* Close file... */
   NC(nc_close(ncid));
+
+  /* Update Cartesian coordinates... */
+  if (pert->cart != NULL)
+    pert2cart(pert);
 }
 
 /*****************************************************************************/
@@ -1260,3 +1565,116 @@ void write_l2(
   /* Close file... */
   NC(nc_close(ncid));
 }
+
+/*****************************************************************************/
+
+void write_l1_l2(
+  char *filename,
+  iasi_l1_t *l1,
+  iasi_l2_t *l2,
+  int level,
+  int shuffle) {
+
+  size_t chunk[3];
+
+  int dimid[6], i, ncid, varid[14], l1_time_id, l1_lon_id, l1_lat_id,
+    l1_sat_z_id, l1_sat_lon_id, l1_sat_lat_id, l1_nu_id, l1_rad_id,
+    l2_time_id, l2_z_id, l2_lon_id, l2_lat_id, l2_p_id, l2_t_id;
+
+  /* Create netCDF file... */
+  LOG(1, "Write IASI Level-1/2 file: %s", filename);
+  NC(nc_create(filename, NC_CLOBBER | NC_NETCDF4, &ncid));
+
+  /* Set dimensions... */
+  NC(nc_def_dim(ncid, "L1_NTRACK", l1->ntrack, &dimid[0]));
+  NC(nc_def_dim(ncid, "L1_NXTRACK", L1_NXTRACK, &dimid[1]));
+  NC(nc_def_dim(ncid, "L1_NCHAN", L1_NCHAN, &dimid[2]));
+  NC(nc_def_dim(ncid, "L2_NTRACK", l2->ntrack, &dimid[3]));
+  NC(nc_def_dim(ncid, "L2_NXTRACK", L2_NXTRACK, &dimid[4]));
+  NC(nc_def_dim(ncid, "L2_NLAY", L2_NLAY, &dimid[5]));
+
+  /* Add Level-1 variables... */
+  add_var(ncid, "l1_time", "s", "time (seconds since 2000-01-01T00:00Z)",
+	  NC_DOUBLE, dimid, &l1_time_id, 2);
+  add_var(ncid, "l1_lon", "deg", "longitude",
+	  NC_DOUBLE, dimid, &l1_lon_id, 2);
+  add_var(ncid, "l1_lat", "deg", "latitude",
+	  NC_DOUBLE, dimid, &l1_lat_id, 2);
+  add_var(ncid, "l1_sat_z", "km", "satellite altitude",
+	  NC_DOUBLE, dimid, &l1_sat_z_id, 1);
+  add_var(ncid, "l1_sat_lon", "deg", "(estimated) satellite longitude",
+	  NC_DOUBLE, dimid, &l1_sat_lon_id, 1);
+  add_var(ncid, "l1_sat_lat", "deg", "(estimated) satellite latitude",
+	  NC_DOUBLE, dimid, &l1_sat_lat_id, 1);
+  add_var(ncid, "l1_nu", "cm^-1", "channel wavenumber",
+	  NC_DOUBLE, &dimid[2], &l1_nu_id, 1);
+  add_var(ncid, "l1_rad", "W/(m^2 sr cm^-1)", "channel radiance",
+	  NC_FLOAT, dimid, &l1_rad_id, 3);
+
+  /* Add Level-2 variables (profiles in single precision)... */
+  add_var(ncid, "l2_time", "s", "time (seconds since 2000-01-01T00:00Z)",
+	  NC_DOUBLE, &dimid[3], &l2_time_id, 2);
+  add_var(ncid, "l2_z", "km", "altitude", NC_FLOAT, &dimid[3], &l2_z_id, 3);
+  add_var(ncid, "l2_lon", "deg", "longitude",
+	  NC_DOUBLE, &dimid[3], &l2_lon_id, 2);
+  add_var(ncid, "l2_lat", "deg", "latitude",
+	  NC_DOUBLE, &dimid[3], &l2_lat_id, 2);
+  add_var(ncid, "l2_press", "hPa", "pressure",
+	  NC_DOUBLE, &dimid[5], &l2_p_id, 1);
+  add_var(ncid, "l2_temp", "K", "temperature",
+	  NC_FLOAT, &dimid[3], &l2_t_id, 3);
+
+  /* Store spectra and profiles in chunks of one scan line... */
+  chunk[0] = 1;
+  chunk[1] = L1_NXTRACK;
+  chunk[2] = L1_NCHAN;
+  NC(nc_def_var_chunking(ncid, l1_rad_id, NC_CHUNKED, chunk));
+  chunk[1] = L2_NXTRACK;
+  chunk[2] = L2_NLAY;
+  NC(nc_def_var_chunking(ncid, l2_z_id, NC_CHUNKED, chunk));
+  NC(nc_def_var_chunking(ncid, l2_t_id, NC_CHUNKED, chunk));
+
+  /* Set compression... */
+  if (level > 0) {
+    varid[0] = l1_time_id;
+    varid[1] = l1_lon_id;
+    varid[2] = l1_lat_id;
+    varid[3] = l1_sat_z_id;
+    varid[4] = l1_sat_lon_id;
+    varid[5] = l1_sat_lat_id;
+    varid[6] = l1_nu_id;
+    varid[7] = l1_rad_id;
+    varid[8] = l2_time_id;
+    varid[9] = l2_z_id;
+    varid[10] = l2_lon_id;
+    varid[11] = l2_lat_id;
+    varid[12] = l2_p_id;
+    varid[13] = l2_t_id;
+    for (i = 0; i < 14; i++)
+      NC(nc_def_var_deflate(ncid, varid[i], shuffle, 1, level));
+  }
+
+  /* Leave define mode... */
+  NC(nc_enddef(ncid));
+
+  /* Write Level-1 data... */
+  NC(nc_put_var_double(ncid, l1_time_id, l1->time[0]));
+  NC(nc_put_var_double(ncid, l1_lon_id, l1->lon[0]));
+  NC(nc_put_var_double(ncid, l1_lat_id, l1->lat[0]));
+  NC(nc_put_var_double(ncid, l1_sat_z_id, l1->sat_z));
+  NC(nc_put_var_double(ncid, l1_sat_lon_id, l1->sat_lon));
+  NC(nc_put_var_double(ncid, l1_sat_lat_id, l1->sat_lat));
+  NC(nc_put_var_double(ncid, l1_nu_id, l1->nu));
+  NC(nc_put_var_float(ncid, l1_rad_id, &l1->rad[0][0][0]));
+
+  /* Write Level-2 data... */
+  NC(nc_put_var_double(ncid, l2_time_id, l2->time[0]));
+  NC(nc_put_var_double(ncid, l2_z_id, l2->z[0][0]));
+  NC(nc_put_var_double(ncid, l2_lon_id, l2->lon[0]));
+  NC(nc_put_var_double(ncid, l2_lat_id, l2->lat[0]));
+  NC(nc_put_var_double(ncid, l2_p_id, l2->p));
+  NC(nc_put_var_double(ncid, l2_t_id, l2->t[0][0]));
+
+  /* Close file... */
+  NC(nc_close(ncid));
+}
@@ -251,6 +251,9 @@ typedef struct {
   /*! Brightness temperature variance (4 or 15 micron) [K]. */
   double var[PERT_NTRACK][PERT_NXTRACK];
 
+  /*! Cartesian coordinates of footprints [km] (set by pert2cart). */
+  double (*cart)[PERT_NXTRACK][3];
+
 } pert_t;
 
 /*! IASI raw Level-1 data. */
@@ -358,6 +361,23 @@ typedef struct {
 
 } wave_t;
 
+/*! Spatial index of footprints (k-d tree on Cartesian coordinates). */
+typedef struct {
+
+  /*! Number of indexed footprints. */
+  int n;
+
+  /*! Cartesian coordinates of footprints [km]. */
+  double (*x)[3];
+
+  /*! Footprint indices in tree order. */
+  int *idx;
+
+  /*! Split axis of tree nodes. */
+  int *axis;
+
+} kdtree_t;
+
 /* ------------------------------------------------------------
    Functions...
    ------------------------------------------------------------ */
@@ -418,6 +438,33 @@ void iasi_read_netcdf(
   char *filename,
   iasi_rad_t * iasi_rad);
 
+/*! Build spatial index of footprints. */
+void kdtree_build(
+  kdtree_t * kd,
+  const double *lon,
+  const double *lat,
+  int n);
+
+/*! Free spatial index of footprints. */
+void kdtree_free(
+  kdtree_t * kd);
+
+/*! Find nearest footprint (returns footprint index or -1). */
+int kdtree_nearest(
+  const kdtree_t * kd,
+  double lon,
+  double lat,
+  double *dist);
+
+/*! Find footprints within search radius (returns number of footprints). */
+int kdtree_radius(
+  const kdtree_t * kd,
+  double lon,
+  double lat,
+  double r,
+  int *list,
+  int nmax);
+
 /*! Apply median filter to perturbations... */
 void median(
   wave_t * wave,
@@ -429,6 +476,18 @@ void noise(
   double *mu,
   double *sig);
 
+/*! Estimate noise of all channels for a block of tracks. */
+void noise_chan(
+  iasi_rad_t * iasi_rad,
+  int track0,
+  int track1,
+  double *mu,
+  double *sig);
+
+/*! Get Cartesian coordinates of perturbation data footprints. */
+void pert2cart(
+  pert_t * pert);
+
 /*! Convert radiance perturbation data to wave analysis struct. */
 void pert2wave(
   pert_t * pert,
@@ -462,3 +521,11 @@ void write_l1(
 void write_l2(
   char *filename,
   iasi_l2_t * l2);
+
+/*! Write IASI Level-1 and Level-2 data to a NetCDF-4 file. */
+void write_l1_l2(
+  char *filename,
+  iasi_l1_t * l1,
+  iasi_l2_t * l2,
+  int level,
+  int shuffle);
@@ -232,6 +232,7 @@ int main(
   fclose(out);
 
   /* Free... */
+  free(pert->cart);
   free(pert);
   free(pert2);
 
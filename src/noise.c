@@ -25,19 +25,29 @@
 
 #include "libiasi.h"
 
+/* ------------------------------------------------------------
+   Dimensions...
+   ------------------------------------------------------------ */
+
+/* Number of tracks per block... */
+#define NBLK 60
+
+/* ------------------------------------------------------------
+   Main...
+   ------------------------------------------------------------ */
+
 int main(
   int argc,
   char *argv[]) {
 
   static iasi_rad_t *iasi_rad;
 
-  static wave_t wave;
-
   static FILE *out;
 
-  static double mu, nesr, sigma;
+  static double mu[L1_NTRACK / NBLK + 1][IASI_L1_NCHAN],
+    sigma[L1_NTRACK / NBLK + 1][IASI_L1_NCHAN], nesr;
 
-  static int ichan, itrack, ix, iy, format;
+  static int ib, ichan, nb, format;
 
   /* Check arguments... */
   if (argc < 4)
@@ -53,6 +63,24 @@ int main(
   printf("Read IASI data: %s\n", argv[2]);
   iasi_read(format, argv[2], iasi_rad);
 
+  /* Analyze blocks of data... */
+  nb = (iasi_rad->ntrack + NBLK - 1) / NBLK;
+#pragma omp parallel for default(none) shared(iasi_rad,nb,mu,sigma) schedule(dynamic)
+  for (int jb = 0; jb < nb; jb++) {
+
+    /* Check number of data points... */
+    const int track0 = jb * NBLK;
+    const int track1 = GSL_MIN(track0 + NBLK, iasi_rad->ntrack);
+    if (track1 - track0 < 55) {
+      for (int jchan = 0; jchan < IASI_L1_NCHAN; jchan++)
+	sigma[jb][jchan] = GSL_NAN;
+      continue;
+    }
+
+    /* Get noise of all channels... */
+    noise_chan(iasi_rad, track0, track1, mu[jb], sigma[jb]);
+  }
+
   /* Create file... */
   printf("Write noise data: %s\n", argv[3]);
   if (!(out = fopen(argv[3], "w")))
@@ -66,8 +94,8 @@ int main(
 	  "# $4 = mean BT [K]\n"
 	  "# $5 = NEDT [K]\n" "# $6 = NESR [W/(m^2 sr cm^-1)]\n");
 
-  /* Analyze blocks of data... */
-  for (itrack = 0; itrack < iasi_rad->ntrack; itrack += 60) {
+  /* Loop over blocks... */
+  for (ib = 0; ib < nb; ib++) {
 
     /* Write empty line... */
     fprintf(out, "\n");
@@ -75,31 +103,14 @@ int main(
     /* Loop over channels... */
     for (ichan = 0; ichan < IASI_L1_NCHAN; ichan++) {
 
-      /* Set wave struct... */
-      wave.nx = L1_NXTRACK;
-      wave.ny = 0;
-      for (iy = itrack; iy < GSL_MIN(itrack + 60, iasi_rad->ntrack); iy++) {
-	for (ix = 0; ix < wave.nx; ix++)
-	  wave.temp[ix][wave.ny] = BRIGHT(iasi_rad->Rad[iy][ix][ichan],
-					  iasi_rad->freq[ichan]);
-	wave.ny++;
-      }
-
-      /* Check number of data points... */
-      if (wave.ny >= 55) {
-
-	/* Get noise... */
-	noise(&wave, &mu, &sigma);
-
-	/* Get NESR... */
-	nesr = PLANCK(mu + sigma, iasi_rad->freq[ichan])
-	  - PLANCK(mu, iasi_rad->freq[ichan]);
-
-	/* Write output... */
-	if (gsl_finite(sigma))
-	  fprintf(out, "%d %d %.4f %g %g %g\n", itrack, ichan,
-		  iasi_rad->freq[ichan], mu, sigma, nesr);
-      }
+      /* Get NESR... */
+      nesr = PLANCK(mu[ib][ichan] + sigma[ib][ichan], iasi_rad->freq[ichan])
+	- PLANCK(mu[ib][ichan], iasi_rad->freq[ichan]);
+
+      /* Write output... */
+      if (gsl_finite(sigma[ib][ichan]))
+	fprintf(out, "%d %d %.4f %g %g %g\n", ib * NBLK, ichan,
+		iasi_rad->freq[ichan], mu[ib][ichan], sigma[ib][ichan], nesr);
     }
   }
 
@@ -267,6 +267,10 @@ int main(
      Calculate perturbations and variances...
      ------------------------------------------------------------ */
 
+  /* Get Cartesian coordinates (geolocation is the same for all bands)... */
+  pert2cart(pert_4mu);
+  pert_15mu_low->cart = pert_15mu_high->cart = pert_4mu->cart;
+
   /* Convert to wave analysis struct... */
   pert2wave(pert_4mu, &wave,
 	    0, pert_4mu->ntrack - 1, 0, pert_4mu->nxtrack - 1);
@@ -427,6 +431,7 @@ int main(
 
   /* Free... */
   free(iasi_rad);
+  free(pert_4mu->cart);
   free(pert_4mu);
   free(pert_15mu_low);
   free(pert_15mu_high);
@@ -61,6 +61,22 @@
 /*! Across-track size of IASI retrieval granule (don't change). */
 #define L2_NXTRACK 60
 
+/*! Maximum number of granules. */
+#define NFILE 100000
+
+/* ------------------------------------------------------------
+   MPI message tags...
+   ------------------------------------------------------------ */
+
+/*! Work request and results (worker to master). */
+#define TAG_RES 1
+
+/*! Result data (worker to master). */
+#define TAG_DATA 2
+
+/*! Work unit (master to worker). */
+#define TAG_WORK 3
+
 /* ------------------------------------------------------------
    Structs...
    ------------------------------------------------------------ */
@@ -124,6 +140,102 @@ typedef struct {
 
 } ncd_t;
 
+/*! Retrieval context (scratch data of one thread). */
+typedef struct {
+
+  /*! A priori atmospheric data. */
+  atm_t atm_apr;
+
+  /*! Retrieved atmospheric data. */
+  atm_t atm_i;
+
+  /*! IASI Level-2 atmospheric data. */
+  atm_t atm_iasi;
+
+  /*! Simulated observation data. */
+  obs_t obs_i;
+
+  /*! Measured observation data. */
+  obs_t obs_meas;
+
+  /*! Warm-start data (result of previous footprint). */
+  warm_t warm;
+
+} rctx_t;
+
+/*! Retrieval settings. */
+typedef struct {
+
+  /*! Number of retrieval altitudes. */
+  int nz;
+
+  /*! Retrieval altitudes [km]. */
+  double z[NP];
+
+  /*! Index of first granule. */
+  int task0;
+
+  /*! Index of last granule. */
+  int task1;
+
+  /*! Index of first track. */
+  int track0;
+
+  /*! Index of last track. */
+  int track1;
+
+  /*! Index of first across-track footprint. */
+  int xtrack0;
+
+  /*! Index of last across-track footprint. */
+  int xtrack1;
+
+  /*! Index of lowest output altitude. */
+  int np0;
+
+  /*! Index of highest output altitude. */
+  int np1;
+
+  /*! Number of tracks per work unit (0=whole granule). */
+  int work_ntrack;
+
+  /*! Solar zenith angle threshold for daytime measurements [deg]. */
+  double sza_thresh;
+
+  /*! Start retrieval from previous footprint of scan (0=no, 1=yes). */
+  int warm;
+
+  /*! Debug level. */
+  int debug;
+
+} rset_t;
+
+/*! Retrieval results of a granule (collected by MPI master). */
+typedef struct {
+
+  /*! Number of tracks. */
+  int ntrack;
+
+  /*! Number of pending work units. */
+  int nleft;
+
+  /*! All work units have been sent (0=no, 1=yes). */
+  int done;
+
+  /*! Altitude [km]. */
+  float ret_z[NP];
+
+  /*! Pressure [hPa]. */
+  float *ret_p;
+
+  /*! Temperature [K]. */
+  float *ret_t;
+
+  /*! chi^2 value of fit. */
+  float *ret_chisq;
+
+} res_t;
+
 /* ------------------------------------------------------------
    Functions...
    ------------------------------------------------------------ */
@@ -149,24 +261,75 @@ void buffer_nc(
   int np0,
   int np1);
 
-/*! Initialize with IASI Level-2 data. */
+/*! Initialize a priori data with IASI Level-2 data. */
 void init_l2(
   ncd_t * ncd,
   int track,
   int xtrack,
   ctl_t * ctl,
-  atm_t * atm);
+  rctx_t * rc);
+
+/*! Read granule and prepare retrieval. */
+void init_granule(
+  ctl_t * ctl,
+  rset_t * set,
+  char *filename,
+  ncd_t * ncd,
+  atm_t * atm_clim,
+  int *channel);
 
 /*! Read netCDF file. */
 void read_nc(
   char *filename,
   ncd_t * ncd);
 
+/*! Retrieve a range of tracks of a granule. */
+void retrieve_tracks(
+  ctl_t * ctl,
+  ret_t * ret,
+  tbl_t * tbl,
+  rset_t * set,
+  ncd_t * ncd,
+  atm_t * atm_clim,
+  rctx_t * rctx,
+  int *channel,
+  int track0,
+  int track1,
+  int ntask);
+
+/*! Distribute work units to MPI workers and write results. */
+void run_master(
+  rset_t * set,
+  char files[][LEN],
+  int nfile,
+  int size,
+  ncd_t * ncd);
+
+/*! Retrieve work units received from MPI master. */
+void run_worker(
+  ctl_t * ctl,
+  ret_t * ret,
+  tbl_t * tbl,
+  rset_t * set,
+  char files[][LEN],
+  ncd_t * ncd,
+  atm_t * atm_clim,
+  rctx_t * rctx,
+  int rank,
+  int size);
+
 /*! Write to netCDF file... */
 void write_nc(
   char *filename,
   ncd_t * ncd);
 
+/*! Write retrieval results of a granule collected by MPI master. */
+void write_res(
+  char *filename,
+  res_t ** res,
+  int np,
+  ncd_t * ncd);
+
 /* ------------------------------------------------------------
    Main...
    ------------------------------------------------------------ */
@@ -176,20 +339,18 @@ int main(
   char *argv[]) {
 
   static ctl_t ctl;
-  static atm_t atm_apr, atm_clim, atm_i;
-  static obs_t obs_i, obs_meas;
+  static atm_t atm_clim;
   static ncd_t ncd;
   static ret_t ret;
+  static rset_t set;
 
-  FILE *in;
+  static rctx_t *rctx;
 
-  char filename[LEN], filename2[LEN];
+  static char (*files)[LEN];
 
-  double chisq, sza_thresh, z[NP], t0;
+  FILE *in;
 
-  int channel[ND], i, id, ip, iz, nz, ntask = -1, rank, size,
-    np0, np1, track, track0, track1, xtrack, xtrack0, xtrack1,
-    task0, task1, debug;
+  int channel[ND], ifile, iz, nfile = 0, rank, size;
 
   /* ------------------------------------------------------------
      Init...
@@ -210,180 +371,142 @@ int main(
   /* Read control parameters... */
   read_ctl(argc, argv, &ctl);
   read_ret(argc, argv, &ctl, &ret);
-  debug = (int) scan_ctl(argc, argv, "DEBUG", -1, "1", NULL);
+  if ((ret.err_ana || ctl.write_matrix) && omp_get_max_threads() > 1)
+    ERRMSG("Set OMP_NUM_THREADS=1 for ERR_ANA or WRITE_MATRIX!");
+  set.debug = (int) scan_ctl(argc, argv, "DEBUG", -1, "1", NULL);
 
   /* Initialize look-up tables... */
-  tbl_t *tbl = read_tbl(&ctl);
+  tbl_t *tbl = (size > 1 && rank == 0 ? NULL : read_tbl(&ctl));
 
   /* Read retrieval grid... */
-  nz = (int) scan_ctl(argc, argv, "NZ", -1, "", NULL);
-  if (nz > NP)
+  set.nz = (int) scan_ctl(argc, argv, "NZ", -1, "", NULL);
+  if (set.nz > NP)
     ERRMSG("Too many altitudes!");
-  for (iz = 0; iz < nz; iz++)
-    z[iz] = scan_ctl(argc, argv, "Z", iz, "", NULL);
+  for (iz = 0; iz < set.nz; iz++)
+    set.z[iz] = scan_ctl(argc, argv, "Z", iz, "", NULL);
 
   /* Read task range... */
-  task0 = (int) scan_ctl(argc, argv, "TASK_MIN", -1, "0", NULL);
-  task1 = (int) scan_ctl(argc, argv, "TASK_MAX", -1, "99999", NULL);
+  set.task0 = (int) scan_ctl(argc, argv, "TASK_MIN", -1, "0", NULL);
+  set.task1 = (int) scan_ctl(argc, argv, "TASK_MAX", -1, "99999", NULL);
 
   /* Read track range... */
-  track0 = (int) scan_ctl(argc, argv, "TRACK_MIN", -1, "0", NULL);
-  track1 = (int) scan_ctl(argc, argv, "TRACK_MAX", -1, "99999", NULL);
+  set.track0 = (int) scan_ctl(argc, argv, "TRACK_MIN", -1, "0", NULL);
+  set.track1 = (int) scan_ctl(argc, argv, "TRACK_MAX", -1, "99999", NULL);
 
   /* Read xtrack range... */
-  xtrack0 = (int) scan_ctl(argc, argv, "XTRACK_MIN", -1, "0", NULL);
-  xtrack1 = (int) scan_ctl(argc, argv, "XTRACK_MAX", -1, "59", NULL);
+  set.xtrack0 = (int) scan_ctl(argc, argv, "XTRACK_MIN", -1, "0", NULL);
+  set.xtrack1 = (int) scan_ctl(argc, argv, "XTRACK_MAX", -1, "59", NULL);
 
   /* Read height range... */
-  np0 = (int) scan_ctl(argc, argv, "NP_MIN", -1, "0", NULL);
-  np1 = (int) scan_ctl(argc, argv, "NP_MAX", -1, "100", NULL);
-  np1 = GSL_MIN(np1, nz - 1);
+  set.np0 = (int) scan_ctl(argc, argv, "NP_MIN", -1, "0", NULL);
+  set.np1 = (int) scan_ctl(argc, argv, "NP_MAX", -1, "100", NULL);
+  set.np1 = GSL_MIN(set.np1, set.nz - 1);
 
   /* SZA threshold... */
-  sza_thresh = scan_ctl(argc, argv, "SZA", -1, "96", NULL);
+  set.sza_thresh = scan_ctl(argc, argv, "SZA", -1, "96", NULL);
 
-  /* ------------------------------------------------------------
-     Distribute granules...
-     ------------------------------------------------------------ */
+  /* Warm start... */
+  set.warm = (int) scan_ctl(argc, argv, "WARM_START", -1, "0", NULL);
+
+  /* Size of work units... */
+  set.work_ntrack = (int) scan_ctl(argc, argv, "WORK_NTRACK", -1, "0", NULL);
+  if (set.work_ntrack <= 0)
+    set.work_ntrack = L1_NTRACK;
 
-  /* Open filelist... */
+  /* Allocate... */
+  ALLOC(rctx, rctx_t, omp_get_max_threads());
+  ALLOC(files, char,
+	NFILE * LEN);
+
+  /* Read filelist... */
   printf("Read filelist: %s\n", argv[2]);
   if (!(in = fopen(argv[2], "r")))
     ERRMSG("Cannot open filelist!");
+  while (fscanf(in, "%s", files[nfile]) != EOF)
+    if ((++nfile) >= NFILE)
+      ERRMSG("Too many granules!");
+  fclose(in);
 
-  /* Loop over netCDF files... */
-  while (fscanf(in, "%s", filename) != EOF) {
+  /* ------------------------------------------------------------
+     Retrieval...
+     ------------------------------------------------------------ */
 
-    /* Distribute files with MPI... */
-    if ((++ntask) % size != rank)
-      continue;
+  /* Distribute work units with MPI... */
+  if (size > 1) {
+    if (rank == 0)
+      run_master(&set, files, nfile, size, &ncd);
+    else
+      run_worker(&ctl, &ret, tbl, &set, files, &ncd, &atm_clim, rctx,
+		 rank, size);
+  }
 
-    /* Check task range... */
-    if (ntask < task0 || ntask > task1)
-      continue;
+  /* Retrieve granules on a single rank... */
+  else
+    for (ifile = set.task0; ifile <= GSL_MIN(set.task1, nfile - 1); ifile++) {
 
-    /* Write info... */
-    printf("Retrieve file %s on rank %d of %d (with %d threads)...\n",
-	   filename, rank + 1, size, omp_get_max_threads());
-
-    /* ------------------------------------------------------------
-       Initialize retrieval...
-       ------------------------------------------------------------ */
-
-    /* Read netCDF file... */
-    read_nc(filename, &ncd);
-
-    /* Adjust number of tracks... */
-    if (track1 >= ncd.ntrack)
-      track1 = ncd.ntrack - 1;
-
-    /* Identify radiance channels... */
-    for (id = 0; id < ctl.nd; id++) {
-      channel[id] = -999;
-      for (i = 0; i < L1_NCHAN; i++)
-	if (fabs(ctl.nu[id] - ncd.l1_nu[i]) < 0.1)
-	  channel[id] = i;
-      if (channel[id] < 0)
-	ERRMSG("Cannot identify radiance channel!");
-    }
+      /* Write info... */
+      printf("Retrieve file %s (with %d threads)...\n",
+	     files[ifile], omp_get_max_threads());
 
-    /* Set climatological data for center of granule... */
-    atm_clim.np = nz;
-    for (iz = 0; iz < nz; iz++)
-      atm_clim.z[iz] = z[iz];
-    climatology(&ctl, &atm_clim);
-
-    /* ------------------------------------------------------------
-       Retrieval...
-       ------------------------------------------------------------ */
-
-    /* Loop over swaths... */
-    for (track = track0; track <= track1; track++) {
-
-      /* Loop over scan... */
-      for (xtrack = xtrack0; xtrack <= xtrack1; xtrack++) {
-
-	/* Init timer... */
-	t0 = omp_get_wtime();
-
-	/* Store observation data... */
-	obs_meas.nr = 1;
-	obs_meas.time[0] = ncd.l1_time[track][xtrack];
-	obs_meas.obsz[0] = ncd.l1_sat_z[track];
-	obs_meas.obslon[0] = ncd.l1_sat_lon[track];
-	obs_meas.obslat[0] = ncd.l1_sat_lat[track];
-	obs_meas.vplon[0] = ncd.l1_lon[track][xtrack];
-	obs_meas.vplat[0] = ncd.l1_lat[track][xtrack];
-	for (id = 0; id < ctl.nd; id++)
-	  obs_meas.rad[id][0] = ncd.l1_rad[track][xtrack][channel[id]];
-
-	/* Flag out 4 micron channels for daytime measurements... */
-	if (RAD2DEG(acos(cos_sza(obs_meas.time[0], obs_meas.obslon[0],
-				 obs_meas.obslat[0]))) < sza_thresh)
-	  for (id = 0; id < ctl.nd; id++)
-	    if (ctl.nu[id] >= 2000)
-	      obs_meas.rad[id][0] = GSL_NAN;
-
-	/* Prepare atmospheric data... */
-	copy_atm(&ctl, &atm_apr, &atm_clim, 0);
-	for (ip = 0; ip < atm_apr.np; ip++) {
-	  atm_apr.time[ip] = obs_meas.time[0];
-	  atm_apr.lon[ip] = obs_meas.vplon[0];
-	  atm_apr.lat[ip] = obs_meas.vplat[0];
-	}
+      /* Initialize retrieval... */
+      init_granule(&ctl, &set, files[ifile], &ncd, &atm_clim, channel);
 
-	/* Merge Level-2 data... */
-	init_l2(&ncd, track, xtrack, &ctl, &atm_apr);
-
-	/* Retrieval... */
-	optimal_estimation(&ret, &ctl, tbl, &obs_meas, &obs_i,
-			   &atm_apr, &atm_i, &chisq);
-
-	/* Buffer results... */
-	buffer_nc(&atm_i, chisq, &ncd, track, xtrack, np0, np1);
-
-	/* Write debug information... */
-	if (debug >= 1)
-	  printf
-	    ("  task= %4d | track= %5d | xtrack= %3d | chi^2= %8.3f | time= %8.3f s\n",
-	     ntask, track, xtrack, chisq, omp_get_wtime() - t0);
-	if (debug >= 2) {
-	  sprintf(filename2, "atm_apr_%d_%d_%d.tab", ntask, track, xtrack);
-	  write_atm(NULL, filename2, &ctl, &atm_apr);
-	  sprintf(filename2, "atm_i_%d_%d_%d.tab", ntask, track, xtrack);
-	  write_atm(NULL, filename2, &ctl, &atm_i);
-	  sprintf(filename2, "obs_meas_%d_%d_%d.tab", ntask, track, xtrack);
-	  write_obs(NULL, filename2, &ctl, &obs_meas);
-	  sprintf(filename2, "obs_i_%d_%d_%d.tab", ntask, track, xtrack);
-	  write_obs(NULL, filename2, &ctl, &obs_i);
-	}
-      }
-    }
+      /* Retrieval... */
+      retrieve_tracks(&ctl, &ret, tbl, &set, &ncd, &atm_clim, rctx, channel,
+		      set.track0, GSL_MIN(set.track1, ncd.ntrack - 1), ifile);
 
-    /* ------------------------------------------------------------
-       Finalize...
-       ------------------------------------------------------------ */
+      /* Write netCDF file... */
+      write_nc(files[ifile], &ncd);
 
-    /* Write netCDF file... */
-    write_nc(filename, &ncd);
+      /* Write info... */
+      printf("Retrieval finished!\n");
+    }
 
-    /* Write info... */
-    printf("Retrieval finished on rank %d of %d!\n", rank, size);
-  }
+  /* ------------------------------------------------------------
+     Finalize...
+     ------------------------------------------------------------ */
 
-  /* Close file list... */
-  fclose(in);
+  /* Free... */
+  for (int i = 0; i < omp_get_max_threads(); i++) {
+    if (rctx[i].warm.x != NULL)
+      gsl_vector_free(rctx[i].warm.x);
+    if (rctx[i].warm.k != NULL)
+      gsl_matrix_free(rctx[i].warm.k);
+  }
+  free(files);
+  free(rctx);
 
   /* Measure CPU time... */
   TIMER("total", 3);
 
   /* Report memory usage... */
-  printf("MEMORY_ATM = %g MByte\n", 4. * sizeof(atm_t) / 1024. / 1024.);
+  printf("MEMORY_ATM = %g MByte\n", 1. * sizeof(atm_t) / 1024. / 1024.);
   printf("MEMORY_CTL = %g MByte\n", 1. * sizeof(ctl_t) / 1024. / 1024.);
+  printf("MEMORY_CTX = %g MByte\n",
+	 1. * omp_get_max_threads() * sizeof(rctx_t) / 1024. / 1024.);
   printf("MEMORY_NCD = %g MByte\n", 1. * sizeof(ncd_t) / 1024. / 1024.);
-  printf("MEMORY_OBS = %g MByte\n", 3. * sizeof(atm_t) / 1024. / 1024.);
   printf("MEMORY_RET = %g MByte\n", 1. * sizeof(ret_t) / 1024. / 1024.);
-  printf("MEMORY_TBL = %g MByte\n", 1. * sizeof(tbl_t) / 1024. / 1024.);
+
+  /* Count allocated table buffers (mapped tables are not counted)... */
+  size_t mem_tbl = sizeof(tbl_t);
+  if (tbl != NULL)
+    for (int id = 0; id < ctl.nd; id++)
+      for (int ig = 0; ig < ctl.ng; ig++) {
+	size_t n = 0;
+	for (int ip = 0; ip < tbl->np[id][ig]; ip++)
+	  for (int it = 0; it < tbl->nt[id][ig][ip]; it++)
+	    n += (size_t) MAX(tbl->nu[id][ig][ip][it], 0);
+	const size_t ntab = (size_t) MAX(tbl->ntab[id][ig], 0);
+	if (tbl->u[id][ig] != NULL && tbl->map[ig] == NULL)
+	  mem_tbl += 2 * n * sizeof(float);
+	if (tbl->uq[id][ig] != NULL)
+	  mem_tbl += 2 * n * sizeof(unsigned short)
+	    + 4 * ntab * sizeof(double);
+	if (tbl->ugd[id][ig] != NULL)
+	  mem_tbl += 2 * ntab * (TBLNB * sizeof(unsigned short)
+				 + sizeof(double));
+      }
+  printf("MEMORY_TBL = %g MByte\n", (double) mem_tbl / 1024. / 1024.);
 
   /* Report problem size... */
   printf("SIZE_TASKS = %d\n", size);
@@ -455,41 +578,41 @@ void init_l2(
   int track,
   int xtrack,
   ctl_t *ctl,
-  atm_t *atm) {
+  rctx_t *rc) {
 
-  static atm_t atm_iasi;
+  atm_t *atm = &rc->atm_apr, *atm_iasi = &rc->atm_iasi;
 
   double k[NW], p, q[NG], t, w, zmax = 0, zmin = 1000;
 
   int ip, lay;
 
   /* Store IASI data in atmospheric data struct... */
-  atm_iasi.np = 0;
+  atm_iasi->np = 0;
   for (lay = 0; lay < L2_NLAY; lay++)
     if (gsl_finite(ncd->l2_z[track][xtrack][lay])
 	&& ncd->l2_z[track][xtrack][lay] <= 60.) {
-      atm_iasi.z[atm_iasi.np] = ncd->l2_z[track][xtrack][lay];
-      atm_iasi.p[atm_iasi.np] = ncd->l2_p[lay];
-      atm_iasi.t[atm_iasi.np] = ncd->l2_t[track][xtrack][lay];
-      if ((++atm_iasi.np) > NP)
+      atm_iasi->z[atm_iasi->np] = ncd->l2_z[track][xtrack][lay];
+      atm_iasi->p[atm_iasi->np] = ncd->l2_p[lay];
+      atm_iasi->t[atm_iasi->np] = ncd->l2_t[track][xtrack][lay];
+      if ((++atm_iasi->np) > NP)
 	ERRMSG("Too many layers!");
     }
 
   /* Check number of levels... */
-  if (atm_iasi.np < 2)
+  if (atm_iasi->np < 2)
     return;
 
   /* Get height range of IASI data... */
-  for (ip = 0; ip < atm_iasi.np; ip++) {
-    zmax = GSL_MAX(zmax, atm_iasi.z[ip]);
-    zmin = GSL_MIN(zmin, atm_iasi.z[ip]);
+  for (ip = 0; ip < atm_iasi->np; ip++) {
+    zmax = GSL_MAX(zmax, atm_iasi->z[ip]);
+    zmin = GSL_MIN(zmin, atm_iasi->z[ip]);
   }
 
   /* Merge IASI data... */
   for (ip = 0; ip < atm->np; ip++) {
 
     /* Interpolate IASI data... */
-    intpol_atm(ctl, &atm_iasi, atm->z[ip], &p, &t, q, k);
+    intpol_atm(ctl, atm_iasi, atm->z[ip], &p, &t, q, k);
 
     /* Weighting factor... */
     w = 1;
@@ -506,6 +629,46 @@ void init_l2(
 
 /*****************************************************************************/
 
+void init_granule(
+  ctl_t *ctl,
+  rset_t *set,
+  char *filename,
+  ncd_t *ncd,
+  atm_t *atm_clim,
+  int *channel) {
+
+  /* Read netCDF file... */
+  read_nc(filename, ncd);
+
+  /* Initialize retrieval results (missing footprints)... */
+  ncd->np = set->np1 - set->np0 + 1;
+  for (int ip = 0; ip < ncd->np; ip++)
+    ncd->ret_z[ip] = (float) set->z[set->np0 + ip];
+  for (int i = 0; i < L1_NTRACK * L1_NXTRACK; i++) {
+    ncd->ret_p[i] = ncd->ret_chisq[i] = GSL_NAN;
+    for (int ip = 0; ip < ncd->np; ip++)
+      ncd->ret_t[i * ncd->np + ip] = GSL_NAN;
+  }
+
+  /* Identify radiance channels... */
+  for (int id = 0; id < ctl->nd; id++) {
+    channel[id] = -999;
+    for (int i = 0; i < L1_NCHAN; i++)
+      if (fabs(ctl->nu[id] - ncd->l1_nu[i]) < 0.1)
+	channel[id] = i;
+    if (channel[id] < 0)
+      ERRMSG("Cannot identify radiance channel!");
+  }
+
+  /* Set climatological data for center of granule... */
+  atm_clim->np = set->nz;
+  for (int iz = 0; iz < set->nz; iz++)
+    atm_clim->z[iz] = set->z[iz];
+  climatology(ctl, atm_clim);
+}
+
+/*****************************************************************************/
+
 void read_nc(
   char *filename,
   ncd_t *ncd) {
@@ -516,7 +679,7 @@ void read_nc(
 
   /* Open netCDF file... */
   printf("Read netCDF file: %s\n", filename);
-  NC(nc_open(filename, NC_WRITE, &ncd->ncid));
+  NC(nc_open(filename, NC_NOWRITE, &ncd->ncid));
 
   /* Read number of tracks... */
   NC(nc_inq_dimid(ncd->ncid, "L1_NTRACK", &dimid));
@@ -548,6 +711,272 @@ void read_nc(
   NC(nc_get_var_double(ncd->ncid, varid, ncd->l2_p));
   NC(nc_inq_varid(ncd->ncid, "l2_temp", &varid));
   NC(nc_get_var_double(ncd->ncid, varid, ncd->l2_t[0][0]));
+
+  /* Close netCDF file... */
+  NC(nc_close(ncd->ncid));
+}
+
+/*****************************************************************************/
+
+void retrieve_tracks(
+  ctl_t *ctl,
+  ret_t *ret,
+  tbl_t *tbl,
+  rset_t *set,
+  ncd_t *ncd,
+  atm_t *atm_clim,
+  rctx_t *rctx,
+  int *channel,
+  int track0,
+  int track1,
+  int ntask) {
+
+  /* Split tracks into segments (warm start needs complete scans)... */
+  const int nx = set->xtrack1 - set->xtrack0 + 1;
+  const int nseg = (set->warm ? 1 : nx);
+
+  /* Loop over segments... */
+#pragma omp parallel for default(none)					\
+  shared(ctl,ret,tbl,set,ncd,atm_clim,rctx,channel,track0,track1,	\
+	 ntask,nx,nseg) schedule(dynamic)
+  for (int iseg = 0; iseg < (track1 - track0 + 1) * nseg; iseg++) {
+
+    /* Get retrieval context... */
+    rctx_t *rc = &rctx[omp_get_thread_num()];
+    rc->warm.valid = 0;
+
+    /* Loop over footprints of segment... */
+    const int track = track0 + iseg / nseg;
+    const int xtrack0 = set->xtrack0 + (iseg % nseg) * (nx / nseg);
+    for (int xtrack = xtrack0; xtrack < xtrack0 + nx / nseg; xtrack++) {
+
+      /* Init timer... */
+      const double t0 = omp_get_wtime();
+
+      /* Store observation data... */
+      rc->obs_meas.nr = 1;
+      rc->obs_meas.time[0] = ncd->l1_time[track][xtrack];
+      rc->obs_meas.obsz[0] = ncd->l1_sat_z[track];
+      rc->obs_meas.obslon[0] = ncd->l1_sat_lon[track];
+      rc->obs_meas.obslat[0] = ncd->l1_sat_lat[track];
+      rc->obs_meas.vplon[0] = ncd->l1_lon[track][xtrack];
+      rc->obs_meas.vplat[0] = ncd->l1_lat[track][xtrack];
+      for (int id = 0; id < ctl->nd; id++)
+	rc->obs_meas.rad[id][0] = ncd->l1_rad[track][xtrack][channel[id]];
+
+      /* Flag out 4 micron channels for daytime measurements... */
+      if (RAD2DEG(acos(cos_sza(rc->obs_meas.time[0], rc->obs_meas.obslon[0],
+			       rc->obs_meas.obslat[0]))) < set->sza_thresh)
+	for (int id = 0; id < ctl->nd; id++)
+	  if (ctl->nu[id] >= 2000)
+	    rc->obs_meas.rad[id][0] = GSL_NAN;
+
+      /* Prepare atmospheric data... */
+      copy_atm(ctl, &rc->atm_apr, atm_clim, 0);
+      for (int ip = 0; ip < rc->atm_apr.np; ip++) {
+	rc->atm_apr.time[ip] = rc->obs_meas.time[0];
+	rc->atm_apr.lon[ip] = rc->obs_meas.vplon[0];
+	rc->atm_apr.lat[ip] = rc->obs_meas.vplat[0];
+      }
+
+      /* Merge Level-2 data... */
+      init_l2(ncd, track, xtrack, ctl, rc);
+
+      /* Retrieval... */
+      double chisq;
+      optimal_estimation_warm(ret, ctl, tbl, &rc->obs_meas, &rc->obs_i,
+			      &rc->atm_apr, &rc->atm_i, &chisq,
+			      set->warm ? &rc->warm : NULL);
+
+      /* Buffer results... */
+      buffer_nc(&rc->atm_i, chisq, ncd, track, xtrack, set->np0, set->np1);
+
+      /* Write debug information... */
+      if (set->debug >= 1)
+	printf
+	  ("  task= %4d | track= %5d | xtrack= %3d | chi^2= %8.3f | time= %8.3f s\n",
+	   ntask, track, xtrack, chisq, omp_get_wtime() - t0);
+      if (set->debug >= 2) {
+	char filename2[LEN];
+	sprintf(filename2, "atm_apr_%d_%d_%d.tab", ntask, track, xtrack);
+	write_atm(NULL, filename2, ctl, &rc->atm_apr);
+	sprintf(filename2, "atm_i_%d_%d_%d.tab", ntask, track, xtrack);
+	write_atm(NULL, filename2, ctl, &rc->atm_i);
+	sprintf(filename2, "obs_meas_%d_%d_%d.tab", ntask, track, xtrack);
+	write_obs(NULL, filename2, ctl, &rc->obs_meas);
+	sprintf(filename2, "obs_i_%d_%d_%d.tab", ntask, track, xtrack);
+	write_obs(NULL, filename2, ctl, &rc->obs_i);
+      }
+    }
+  }
+}
+
+/*****************************************************************************/
+
+void run_master(
+  rset_t *set,
+  char files[][LEN],
+  int nfile,
+  int size,
+  ncd_t *ncd) {
+
+  MPI_Status status;
+
+  res_t **res, *r;
+
+  int dimid, hdr[3], ifile = 0, itrack = -1, ncid, nwork = size - 1,
+    ntrack = 0, src;
+
+  size_t len;
+
+  /* Get number of output altitudes... */
+  const int np = set->np1 - set->np0 + 1;
+
+  /* Allocate... */
+  ALLOC(res, res_t *, NFILE);
+
+  /* Loop until all workers are finished... */
+  while (nwork > 0) {
+
+    /* Receive work request... */
+    MPI_Recv(hdr, 3, MPI_INT, MPI_ANY_SOURCE, TAG_RES, MPI_COMM_WORLD,
+	     &status);
+    src = status.MPI_SOURCE;
+
+    /* Receive results of previous work unit... */
+    if (hdr[0] >= 0) {
+      r = res[hdr[0]];
+      const int n = (hdr[2] - hdr[1] + 1) * L1_NXTRACK;
+      MPI_Recv(&r->ret_chisq[hdr[1] * L1_NXTRACK], n, MPI_FLOAT, src,
+	       TAG_DATA, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      MPI_Recv(&r->ret_p[hdr[1] * L1_NXTRACK], n, MPI_FLOAT, src,
+	       TAG_DATA, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      MPI_Recv(&r->ret_t[hdr[1] * L1_NXTRACK * np], n * np, MPI_FLOAT, src,
+	       TAG_DATA, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      MPI_Recv(r->ret_z, np, MPI_FLOAT, src,
+	       TAG_DATA, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+      /* Write granule if all its work units are done... */
+      if (--r->nleft == 0 && r->done)
+	write_res(files[hdr[0]], &res[hdr[0]], np, ncd);
+    }
+
+    /* Find next work unit... */
+    hdr[0] = -1;
+    for (; ifile <= GSL_MIN(set->task1, nfile - 1); ifile++, itrack = -1) {
+
+      /* Check task range... */
+      if (ifile < set->task0)
+	continue;
+
+      /* Start new granule... */
+      if (itrack < 0) {
+	NC(nc_open(files[ifile], NC_NOWRITE, &ncid));
+	NC(nc_inq_dimid(ncid, "L1_NTRACK", &dimid));
+	NC(nc_inq_dimlen(ncid, dimid, &len));
+	NC(nc_close(ncid));
+	ntrack = (int) len;
+	ALLOC(res[ifile], res_t, 1);
+	res[ifile]->ntrack = ntrack;
+	ALLOC(res[ifile]->ret_p, float,
+	      ntrack * L1_NXTRACK);
+	ALLOC(res[ifile]->ret_t, float,
+	      ntrack * L1_NXTRACK * np);
+	ALLOC(res[ifile]->ret_chisq, float,
+	      ntrack * L1_NXTRACK);
+	for (int ip = 0; ip < np; ip++)
+	  res[ifile]->ret_z[ip] = (float) set->z[set->np0 + ip];
+	for (int i = 0; i < ntrack * L1_NXTRACK; i++) {
+	  res[ifile]->ret_p[i] = res[ifile]->ret_chisq[i] = GSL_NAN;
+	  for (int ip = 0; ip < np; ip++)
+	    res[ifile]->ret_t[i * np + ip] = GSL_NAN;
+	}
+	itrack = set->track0;
+      }
+
+      /* Set work unit... */
+      if (itrack <= GSL_MIN(set->track1, ntrack - 1)) {
+	hdr[0] = ifile;
+	hdr[1] = itrack;
+	hdr[2] = GSL_MIN(itrack + set->work_ntrack - 1,
+			 GSL_MIN(set->track1, ntrack - 1));
+	itrack = hdr[2] + 1;
+	res[ifile]->nleft++;
+	break;
+      }
+
+      /* All work units of this granule have been sent... */
+      res[ifile]->done = 1;
+      if (res[ifile]->nleft == 0)
+	write_res(files[ifile], &res[ifile], np, ncd);
+    }
+
+    /* Send work unit (or stop signal)... */
+    MPI_Send(hdr, 3, MPI_INT, src, TAG_WORK, MPI_COMM_WORLD);
+    if (hdr[0] < 0)
+      nwork--;
+  }
+
+  /* Free... */
+  free(res);
+}
+
+/*****************************************************************************/
+
+void run_worker(
+  ctl_t *ctl,
+  ret_t *ret,
+  tbl_t *tbl,
+  rset_t *set,
+  char files[][LEN],
+  ncd_t *ncd,
+  atm_t *atm_clim,
+  rctx_t *rctx,
+  int rank,
+  int size) {
+
+  int channel[ND], hdr[3] = { -1, 0, 0 }, ifile = -1;
+
+  /* Get number of output altitudes... */
+  const int np = set->np1 - set->np0 + 1;
+
+  /* Loop over work units... */
+  while (1) {
+
+    /* Request work and return results of previous work unit... */
+    MPI_Send(hdr, 3, MPI_INT, 0, TAG_RES, MPI_COMM_WORLD);
+    if (hdr[0] >= 0) {
+      const int n = (hdr[2] - hdr[1] + 1) * L1_NXTRACK;
+      MPI_Send(&ncd->ret_chisq[hdr[1] * L1_NXTRACK], n, MPI_FLOAT, 0,
+	       TAG_DATA, MPI_COMM_WORLD);
+      MPI_Send(&ncd->ret_p[hdr[1] * L1_NXTRACK], n, MPI_FLOAT, 0,
+	       TAG_DATA, MPI_COMM_WORLD);
+      MPI_Send(&ncd->ret_t[hdr[1] * L1_NXTRACK * np], n * np, MPI_FLOAT, 0,
+	       TAG_DATA, MPI_COMM_WORLD);
+      MPI_Send(ncd->ret_z, np, MPI_FLOAT, 0, TAG_DATA, MPI_COMM_WORLD);
+    }
+
+    /* Receive work unit... */
+    MPI_Recv(hdr, 3, MPI_INT, 0, TAG_WORK, MPI_COMM_WORLD,
+	     MPI_STATUS_IGNORE);
+    if (hdr[0] < 0)
+      break;
+
+    /* Write info... */
+    printf("Retrieve file %s, tracks %d-%d, on rank %d of %d"
+	   " (with %d threads)...\n", files[hdr[0]], hdr[1], hdr[2],
+	   rank + 1, size, omp_get_max_threads());
+
+    /* Read granule... */
+    if (hdr[0] != ifile) {
+      ifile = hdr[0];
+      init_granule(ctl, set, files[ifile], ncd, atm_clim, channel);
+    }
+
+    /* Retrieval... */
+    retrieve_tracks(ctl, ret, tbl, set, ncd, atm_clim, rctx, channel,
+		    hdr[1], hdr[2], hdr[0]);
+  }
 }
 
 /*****************************************************************************/
@@ -558,8 +987,9 @@ void write_nc(
 
   int dimid[10], c_id, p_id, t_id, z_id;
 
-  /* Create netCDF file... */
+  /* Open netCDF file... */
   printf("Write netCDF file: %s\n", filename);
+  NC(nc_open(filename, NC_WRITE, &ncd->ncid));
 
   /* Read existing dimensions... */
   NC(nc_inq_dimid(ncd->ncid, "L1_NTRACK", &dimid[0]));
@@ -594,3 +1024,35 @@ void write_nc(
   /* Close netCDF file... */
   NC(nc_close(ncd->ncid));
 }
+
+/*****************************************************************************/
+
+void write_res(
+  char *filename,
+  res_t **res,
+  int np,
+  ncd_t *ncd) {
+
+  res_t *r = *res;
+
+  /* Copy results... */
+  ncd->np = np;
+  for (int ip = 0; ip < np; ip++)
+    ncd->ret_z[ip] = r->ret_z[ip];
+  for (int j = 0; j < r->ntrack * L1_NXTRACK; j++) {
+    ncd->ret_p[j] = r->ret_p[j];
+    ncd->ret_chisq[j] = r->ret_chisq[j];
+  }
+  for (int j = 0; j < r->ntrack * L1_NXTRACK * np; j++)
+    ncd->ret_t[j] = r->ret_t[j];
+
+  /* Write netCDF file... */
+  write_nc(filename, ncd);
+
+  /* Free... */
+  free(r->ret_p);
+  free(r->ret_t);
+  free(r->ret_chisq);
+  free(r);
+  *res = NULL;
+}
@@ -25,80 +25,233 @@
 
 #include "libiasi.h"
 
+/* ------------------------------------------------------------
+   Dimensions...
+   ------------------------------------------------------------ */
+
+/* Maximum number of selected footprints... */
+#define NSEL (L1_NTRACK * L1_NXTRACK)
+
+/* ------------------------------------------------------------
+   Functions...
+   ------------------------------------------------------------ */
+
+/* Add footprint to selection. */
+void add_sel(
+  iasi_rad_t * iasi_rad,
+  int track,
+  int xtrack,
+  int *sel_track,
+  int *sel_xtrack,
+  int *nsel);
+
+/* Write spectrum of a footprint. */
+void write_spec(
+  FILE * out,
+  iasi_rad_t * iasi_rad,
+  int track,
+  int xtrack);
+
+/* Write selected spectra to netCDF file. */
+void write_spec_nc(
+  char *filename,
+  iasi_rad_t * iasi_rad,
+  int *sel_track,
+  int *sel_xtrack,
+  int nsel);
+
+/* ------------------------------------------------------------
+   Main...
+   ------------------------------------------------------------ */
+
 int main(
   int argc,
   char *argv[]) {
 
   static iasi_rad_t *iasi_rad;
 
-  FILE *out;
+  static kdtree_t kd;
+
+  FILE *in, *out;
 
-  double dmin = 1e100, x0[3], x1[3];
+  char line[LEN], *outfile;
 
-  int ichan, track = -1, track2, xtrack = -1, xtrack2, format;
+  double dist, lon, lat;
+
+  int *sel_track, *sel_xtrack, geo, i, isel, nsel = 0, track, xtrack,
+    format, outfmt;
 
   /* Check arguments... */
-  if (argc < 7)
-    ERRMSG("Give parameters: <ctl> <iasi_l1b_file> "
-	   "[index <track> <xtrack> | geo <lon> <lat>] <spec.tab>");
+  if (argc < 6)
+    ERRMSG("Give parameters: <ctl> <iasi_l1b_file> [index <track> <xtrack>"
+	   " | geo <lon> <lat> | indexlist <indices.tab>"
+	   " | geolist <targets.tab>] <spec.tab>");
 
   /* Read control parameters... */
   format = (int) scan_ctl(argc, argv, "FORMAT", -1, "1", NULL);
+  outfmt = (int) scan_ctl(argc, argv, "OUTFMT", -1, "1", NULL);
 
   /* Allocate... */
   ALLOC(iasi_rad, iasi_rad_t, 1);
+  ALLOC(sel_track, int, NSEL);
+  ALLOC(sel_xtrack, int, NSEL);
 
   /* Read IASI data... */
   printf("Read IASI Level-1C data file: %s\n", argv[2]);
   iasi_read(format, argv[2], iasi_rad);
 
-  /* Get indices... */
-  if (argv[3][0] == 'i') {
-    track = atoi(argv[4]);
-    xtrack = atoi(argv[5]);
+  /* Build spatial index... */
+  geo = (strcasecmp(argv[3], "geo") == 0
+	 || strcasecmp(argv[3], "geolist") == 0);
+  if (geo)
+    kdtree_build(&kd, iasi_rad->Longitude[0], iasi_rad->Latitude[0],
+		 iasi_rad->ntrack * L1_NXTRACK);
+
+  /* Select footprint by index... */
+  if (strcasecmp(argv[3], "index") == 0) {
+    if (argc < 7)
+      ERRMSG("Missing output file!");
+    outfile = argv[6];
+    add_sel(iasi_rad, atoi(argv[4]), atoi(argv[5]),
+	    sel_track, sel_xtrack, &nsel);
   }
 
   /* Find nearest footprint... */
-  else {
-    geo2cart(0, atof(argv[4]), atof(argv[5]), x0);
-    for (track2 = 0; track2 < iasi_rad->ntrack; track2++)
-      for (xtrack2 = 0; xtrack2 < L1_NXTRACK; xtrack2++) {
-	geo2cart(0, iasi_rad->Longitude[track2][xtrack2],
-		 iasi_rad->Latitude[track2][xtrack2], x1);
-	if (DIST2(x0, x1) < dmin) {
-	  dmin = DIST2(x0, x1);
-	  track = track2;
-	  xtrack = xtrack2;
+  else if (strcasecmp(argv[3], "geo") == 0) {
+    if (argc < 7)
+      ERRMSG("Missing output file!");
+    outfile = argv[6];
+    i = kdtree_nearest(&kd, atof(argv[4]), atof(argv[5]), &dist);
+    if (i < 0 || dist > 50)
+      ERRMSG("Geolocation not covered by granule!");
+    add_sel(iasi_rad, i / L1_NXTRACK, i % L1_NXTRACK,
+	    sel_track, sel_xtrack, &nsel);
+  }
+
+  /* Read list of indices or targets... */
+  else if (strcasecmp(argv[3], "indexlist") == 0
+	   || strcasecmp(argv[3], "geolist") == 0) {
+    outfile = argv[5];
+    printf("Read footprint list: %s\n", argv[4]);
+    if (!(in = fopen(argv[4], "r")))
+      ERRMSG("Cannot open file!");
+    while (fgets(line, LEN, in)) {
+
+      /* Get indices... */
+      if (!geo) {
+	if (sscanf(line, "%d %d", &track, &xtrack) != 2)
+	  continue;
+	if (track < 0 || track >= iasi_rad->ntrack
+	    || xtrack < 0 || xtrack >= L1_NXTRACK) {
+	  WARN("Footprint index out of range: track= %d, xtrack= %d",
+	       track, xtrack);
+	  continue;
 	}
+	add_sel(iasi_rad, track, xtrack, sel_track, sel_xtrack, &nsel);
       }
-    if (dmin > 2500)
-      ERRMSG("Geolocation not covered by granule!");
+
+      /* Find nearest footprint... */
+      else if (sscanf(line, "%lg %lg", &lon, &lat) == 2) {
+	i = kdtree_nearest(&kd, lon, lat, &dist);
+	if (i < 0 || dist > 50) {
+	  WARN("Geolocation not covered by granule: lon= %g, lat= %g",
+	       lon, lat);
+	  continue;
+	}
+	add_sel(iasi_rad, i / L1_NXTRACK, i % L1_NXTRACK,
+		sel_track, sel_xtrack, &nsel);
+      }
+    }
+    fclose(in);
+  }
+
+  /* Error... */
+  else
+    ERRMSG("Unknown footprint selection mode!");
+
+  /* Write info... */
+  LOG(1, "Selected %d footprints.", nsel);
+
+  /* Write ASCII file... */
+  if (outfmt == 1) {
+
+    /* Create file... */
+    printf("Write spectra: %s\n", outfile);
+    if (!(out = fopen(outfile, "w")))
+      ERRMSG("Cannot create file!");
+
+    /* Write header... */
+    fprintf(out,
+	    "# $1 = time (seconds since 01-JAN-2000, 00:00 UTC)\n"
+	    "# $2 = satellite longitude [deg]\n"
+	    "# $3 = satellite latitude [deg]\n"
+	    "# $4 = footprint longitude [deg]\n"
+	    "# $5 = footprint latitude [deg]\n"
+	    "# $6 = wavenumber [cm^-1]\n"
+	    "# $7 = brightness temperature [K]\n"
+	    "# $8 = radiance [W/(m^2 sr cm^-1)]\n");
+
+    /* Write data... */
+    for (isel = 0; isel < nsel; isel++)
+      write_spec(out, iasi_rad, sel_track[isel], sel_xtrack[isel]);
+
+    /* Close file... */
+    fclose(out);
   }
 
+  /* Write netCDF file... */
+  else if (outfmt == 2)
+    write_spec_nc(outfile, iasi_rad, sel_track, sel_xtrack, nsel);
+
+  /* Error... */
+  else
+    ERRMSG("Unknown output format, check OUTFMT!");
+
+  /* Free... */
+  if (geo)
+    kdtree_free(&kd);
+  free(sel_track);
+  free(sel_xtrack);
+  free(iasi_rad);
+
+  return EXIT_SUCCESS;
+}
+
+/*****************************************************************************/
+
+void add_sel(
+  iasi_rad_t *iasi_rad,
+  int track,
+  int xtrack,
+  int *sel_track,
+  int *sel_xtrack,
+  int *nsel) {
+
   /* Check indices... */
   if (track < 0 || track >= iasi_rad->ntrack)
     ERRMSG("Along-track index out of range!");
   if (xtrack < 0 || xtrack >= L1_NXTRACK)
     ERRMSG("Across-track index out of range!");
+  if (*nsel >= NSEL)
+    ERRMSG("Too many footprints selected!");
 
-  /* Create file... */
-  printf("Write spectrum: %s\n", argv[6]);
-  if (!(out = fopen(argv[6], "w")))
-    ERRMSG("Cannot create file!");
-
-  /* Write header... */
-  fprintf(out,
-	  "# $1 = time (seconds since 01-JAN-2000, 00:00 UTC)\n"
-	  "# $2 = satellite longitude [deg]\n"
-	  "# $3 = satellite latitude [deg]\n"
-	  "# $4 = footprint longitude [deg]\n"
-	  "# $5 = footprint latitude [deg]\n"
-	  "# $6 = wavenumber [cm^-1]\n"
-	  "# $7 = brightness temperature [K]\n"
-	  "# $8 = radiance [W/(m^2 sr cm^-1)]\n\n");
+  /* Add footprint... */
+  sel_track[*nsel] = track;
+  sel_xtrack[*nsel] = xtrack;
+  (*nsel)++;
+}
+
+/*****************************************************************************/
+
+void write_spec(
+  FILE *out,
+  iasi_rad_t *iasi_rad,
+  int track,
+  int xtrack) {
 
   /* Write data... */
-  for (ichan = 0; ichan < IASI_L1_NCHAN; ichan++)
+  fprintf(out, "\n");
+  for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++)
     fprintf(out, "%.2f %g %g %g %g %g %g %g\n",
 	    iasi_rad->Time[track][xtrack],
 	    iasi_rad->Sat_lon[track],
@@ -109,12 +262,112 @@ int main(
 	    BRIGHT(iasi_rad->Rad[track][xtrack][ichan],
 		   iasi_rad->freq[ichan]),
 	    iasi_rad->Rad[track][xtrack][ichan]);
+}
 
-  /* Close file... */
-  fclose(out);
+/*****************************************************************************/
 
-  /* Free... */
-  free(iasi_rad);
+void write_spec_nc(
+  char *filename,
+  iasi_rad_t *iasi_rad,
+  int *sel_track,
+  int *sel_xtrack,
+  int nsel) {
 
-  return EXIT_SUCCESS;
+  static double c1[IASI_L1_NCHAN], c2[IASI_L1_NCHAN], time[NSEL], lon[NSEL],
+    lat[NSEL], sat_z[NSEL], sat_lon[NSEL], sat_lat[NSEL];
+
+  static float bt[IASI_L1_NCHAN];
+
+  int dimid[2], ncid, time_varid, lon_varid, lat_varid, sat_z_varid,
+    sat_lon_varid, sat_lat_varid, track_varid, xtrack_varid, nu_varid,
+    rad_varid, bt_varid;
+
+  size_t start[2], count[2];
+
+  /* Check number of footprints... */
+  if (nsel < 1)
+    ERRMSG("No footprints selected!");
+
+  /* Create netCDF file... */
+  printf("Write spectra: %s\n", filename);
+  NC(nc_create(filename, NC_CLOBBER, &ncid));
+
+  /* Set dimensions... */
+  NC(nc_def_dim(ncid, "NSEL", (size_t) nsel, &dimid[0]));
+  NC(nc_def_dim(ncid, "NCHAN", IASI_L1_NCHAN, &dimid[1]));
+
+  /* Add variables... */
+  add_var(ncid, "time", "s", "time (seconds since 2000-01-01T00:00Z)",
+	  NC_DOUBLE, dimid, &time_varid, 1);
+  add_var(ncid, "lon", "deg", "footprint longitude", NC_DOUBLE, dimid,
+	  &lon_varid, 1);
+  add_var(ncid, "lat", "deg", "footprint latitude", NC_DOUBLE, dimid,
+	  &lat_varid, 1);
+  add_var(ncid, "sat_z", "km", "satellite altitude", NC_DOUBLE, dimid,
+	  &sat_z_varid, 1);
+  add_var(ncid, "sat_lon", "deg", "satellite longitude", NC_DOUBLE, dimid,
+	  &sat_lon_varid, 1);
+  add_var(ncid, "sat_lat", "deg", "satellite latitude", NC_DOUBLE, dimid,
+	  &sat_lat_varid, 1);
+  add_var(ncid, "track", "1", "along-track index", NC_INT, dimid,
+	  &track_varid, 1);
+  add_var(ncid, "xtrack", "1", "across-track index", NC_INT, dimid,
+	  &xtrack_varid, 1);
+  add_var(ncid, "nu", "cm^-1", "channel wavenumber", NC_DOUBLE, &dimid[1],
+	  &nu_varid, 1);
+  add_var(ncid, "rad", "W/(m^2 sr cm^-1)", "radiance", NC_FLOAT, dimid,
+	  &rad_varid, 2);
+  add_var(ncid, "bt", "K", "brightness temperature", NC_FLOAT, dimid,
+	  &bt_varid, 2);
+
+  /* Leave define mode... */
+  NC(nc_enddef(ncid));
+
+  /* Write footprint data... */
+  for (int isel = 0; isel < nsel; isel++) {
+    const int track = sel_track[isel], xtrack = sel_xtrack[isel];
+    time[isel] = iasi_rad->Time[track][xtrack];
+    lon[isel] = iasi_rad->Longitude[track][xtrack];
+    lat[isel] = iasi_rad->Latitude[track][xtrack];
+    sat_z[isel] = iasi_rad->Sat_z[track];
+    sat_lon[isel] = iasi_rad->Sat_lon[track];
+    sat_lat[isel] = iasi_rad->Sat_lat[track];
+  }
+  NC(nc_put_var_double(ncid, time_varid, time));
+  NC(nc_put_var_double(ncid, lon_varid, lon));
+  NC(nc_put_var_double(ncid, lat_varid, lat));
+  NC(nc_put_var_double(ncid, sat_z_varid, sat_z));
+  NC(nc_put_var_double(ncid, sat_lon_varid, sat_lon));
+  NC(nc_put_var_double(ncid, sat_lat_varid, sat_lat));
+  NC(nc_put_var_int(ncid, track_varid, sel_track));
+  NC(nc_put_var_int(ncid, xtrack_varid, sel_xtrack));
+  NC(nc_put_var_double(ncid, nu_varid, iasi_rad->freq));
+
+  /* Get coefficients for brightness temperature conversion... */
+  for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++) {
+    c1[ichan] = C1 * POW3(iasi_rad->freq[ichan]);
+    c2[ichan] = C2 * iasi_rad->freq[ichan];
+  }
+
+  /* Loop over selected footprints... */
+  for (int isel = 0; isel < nsel; isel++) {
+
+    /* Set array sizes... */
+    start[0] = (size_t) isel;
+    start[1] = 0;
+    count[0] = 1;
+    count[1] = IASI_L1_NCHAN;
+
+    /* Convert radiances to brightness temperatures... */
+    const float *rad = iasi_rad->Rad[sel_track[isel]][sel_xtrack[isel]];
+    for (int ichan = 0; ichan < IASI_L1_NCHAN; ichan++)
+      bt[ichan] = (float) (c2[ichan] / log1p(c1[ichan] / rad[ichan]));
+
+    /* Write spectra... */
+    NC(nc_put_vara_float(ncid, rad_varid, start, count, rad));
+    NC(nc_put_vara_float(ncid, bt_varid, start, count, bt));
+  }
+
+  /* Close file... */
+  NC(nc_close(ncid));
 }
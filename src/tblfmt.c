@@ -0,0 +1,61 @@
+/*
+  This file is part of the IASI Code Collection.
+
+  the IASI Code Collections is free software: you can redistribute it
+  and/or modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  The IASI Code Collection is distributed in the hope that it will be
+  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with the IASI Code Collection. If not, see
+  <http://www.gnu.org/licenses/>.
+
+  Copyright (C) 2019-2026 Forschungszentrum Juelich GmbH
+*/
+
+/*!
+  \file
+  Convert emissivity look-up tables between file formats.
+*/
+
+#include "libiasi.h"
+
+/* ------------------------------------------------------------
+   Main...
+   ------------------------------------------------------------ */
+
+int main(
+  int argc,
+  char *argv[]) {
+
+  static ctl_t ctl;
+
+  /* Check arguments... */
+  if (argc < 6)
+    ERRMSG("Give parameters: <ctl> <tblbase_in> <tblfmt_in>"
+	   " <tblbase_out> <tblfmt_out>");
+
+  /* Read control parameters... */
+  read_ctl(argc, argv, &ctl);
+  ctl.tblquant = 0;
+
+  /* Read look-up tables... */
+  sprintf(ctl.tblbase, "%s", argv[2]);
+  ctl.tblfmt = atoi(argv[3]);
+  tbl_t *tbl = read_tbl(&ctl);
+
+  /* Write look-up tables... */
+  sprintf(ctl.tblbase, "%s", argv[4]);
+  ctl.tblfmt = atoi(argv[5]);
+  write_tbl(&ctl, tbl);
+
+  /* Free... */
+  free_tbl(&ctl, tbl);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/*
+  This file is part of the IASI Code Collection.
+
+  the IASI Code Collections is free software: you can redistribute it
+  and/or modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  The IASI Code Collection is distributed in the hope that it will be
+  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with the IASI Code Collection. If not, see
+  <http://www.gnu.org/licenses/>.
+
+  Copyright (C) 2019-2026 Forschungszentrum Juelich GmbH
+*/
+
+/*!
+  \file
+  Validate quantised emissivity look-up tables.
+*/
+
+#include "libiasi.h"
+
+/* ------------------------------------------------------------
+   Main...
+   ------------------------------------------------------------ */
+
+int main(
+  int argc,
+  char *argv[]) {
+
+  static ctl_t ctl;
+
+  static atm_t *atm, *atmq;
+
+  static obs_t *obs, *obs2, *obsq;
+
+  static tbl_t *tbl, *tblq;
+
+  static FILE *out;
+
+  static double drad_mean[ND], drad_max[ND], dbt_mean[ND], dbt_max[ND];
+
+  static int n;
+
+  /* Check arguments... */
+  if (argc < 5)
+    ERRMSG("Give parameters: <ctl> <obs.tab> <out.tab>"
+	   " <atm1.tab> [<atm2.tab> ...]");
+
+  /* Read control parameters... */
+  read_ctl(argc, argv, &ctl);
+  ctl.write_bbt = 0;
+
+  /* Allocate... */
+  ALLOC(atm, atm_t, 1);
+  ALLOC(atmq, atm_t, 1);
+  ALLOC(obs, obs_t, 1);
+  ALLOC(obs2, obs_t, 1);
+  ALLOC(obsq, obs_t, 1);
+
+  /* Read float and quantised look-up tables... */
+  ctl.tblquant = 0;
+  tbl = read_tbl(&ctl);
+  ctl.tblquant = 1;
+  tblq = read_tbl(&ctl);
+
+  /* Read observation geometry... */
+  read_obs(NULL, argv[2], &ctl, obs);
+
+  /* Loop over test profiles... */
+  for (int iarg = 4; iarg < argc; iarg++) {
+
+    /* Read atmospheric data... */
+    read_atm(NULL, argv[iarg], &ctl, atm);
+    memcpy(atmq, atm, sizeof(atm_t));
+
+    /* Run forward model with float and quantised tables... */
+    memcpy(obs2, obs, sizeof(obs_t));
+    memcpy(obsq, obs, sizeof(obs_t));
+    formod(&ctl, tbl, atm, obs2);
+    formod(&ctl, tblq, atmq, obsq);
+
+    /* Get radiance and brightness temperature differences... */
+    for (int id = 0; id < ctl.nd; id++)
+      for (int ir = 0; ir < obs->nr; ir++) {
+	const double drad = fabs(obsq->rad[id][ir] - obs2->rad[id][ir]);
+	const double dbt = fabs(BRIGHT(obsq->rad[id][ir], ctl.nu[id])
+				- BRIGHT(obs2->rad[id][ir], ctl.nu[id]));
+	drad_mean[id] += drad;
+	drad_max[id] = GSL_MAX(drad_max[id], drad);
+	dbt_mean[id] += dbt;
+	dbt_max[id] = GSL_MAX(dbt_max[id], dbt);
+      }
+    n += obs->nr;
+  }
+
+  /* Check number of test cases... */
+  if (n <= 0)
+    ERRMSG("No test profiles given!");
+
+  /* Create file... */
+  printf("Write quantisation errors: %s\n", argv[3]);
+  if (!(out = fopen(argv[3], "w")))
+    ERRMSG("Cannot create file!");
+
+  /* Write header... */
+  fprintf(out,
+	  "# $1 = channel wavenumber [cm^-1]\n"
+	  "# $2 = mean absolute radiance error [W/(m^2 sr cm^-1)]\n"
+	  "# $3 = maximum absolute radiance error [W/(m^2 sr cm^-1)]\n"
+	  "# $4 = mean absolute brightness temperature error [K]\n"
+	  "# $5 = maximum absolute brightness temperature error [K]\n\n");
+
+  /* Write data... */
+  double dbt_all = 0;
+  for (int id = 0; id < ctl.nd; id++) {
+    fprintf(out, "%.4f %g %g %g %g\n", ctl.nu[id], drad_mean[id] / n,
+	    drad_max[id], dbt_mean[id] / n, dbt_max[id]);
+    dbt_all = GSL_MAX(dbt_all, dbt_max[id]);
+  }
+
+  /* Close file... */
+  fclose(out);
+
+  /* Write summary... */
+  printf("Number of test cases: %d\n", n);
+  printf("Maximum brightness temperature error: %g K\n", dbt_all);
+
+  /* Free... */
+  free(atm);
+  free(atmq);
+  free(obs);
+  free(obs2);
+  free(obsq);
+  free_tbl(&ctl, tbl);
+  free_tbl(&ctl, tblq);
+
+  return EXIT_SUCCESS;
+}